@@ -0,0 +1,79 @@
+#include "../unordered_map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+// Compares contains() against the find(key) != end() it used to be written as. Half the probes
+// hit; both loops run interleaved and the best of several repetitions is reported. Build with
+// optimizations (e.g. -DCMAKE_BUILD_TYPE=Release), the numbers are meaningless otherwise.
+
+static constexpr int kRepetitions = 15;
+
+template<class Map, class Key>
+static void run(const char* name, const Map& map, const std::vector<Key>& probes) {
+    double best[2] = {1e300, 1e300};
+    size_t hits[2] = {};
+    for (int repetition = 0; repetition < kRepetitions; ++repetition) {
+        for (int mode = 0; mode < 2; ++mode) {
+            size_t found = 0;
+            auto start = std::chrono::steady_clock::now();
+            if (mode == 0) {
+                for (const Key& key : probes) {
+                    found += map.find(key) != map.end();
+                }
+            } else {
+                for (const Key& key : probes) {
+                    found += map.contains(key);
+                }
+            }
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best[mode] = std::min(best[mode], elapsed.count());
+            hits[mode] = found;
+        }
+    }
+    printf("  %-8s find != end %8.1f ms   contains %8.1f ms   (hits %zu/%zu)\n",
+           name, best[0], best[1], hits[1], probes.size());
+    if (hits[0] != hits[1]) {
+        printf("  %-8s MISMATCH: find found %zu\n", name, hits[0]);
+    }
+}
+
+int main() {
+    std::mt19937_64 rng(1);
+    for (size_t size : {size_t(1) << 12, size_t(1) << 20}) {
+        printf("n = %zu\n", size);
+
+        UnorderedMap<uint64_t, uint64_t> numbers;
+        for (size_t i = 0; i < size; ++i) {
+            numbers[rng()] = i;
+        }
+        std::vector<uint64_t> numberKeys;
+        for (const auto& [key, value] : numbers) {
+            numberKeys.push_back(key);
+        }
+        std::vector<uint64_t> numberProbes;
+        for (size_t i = 0; i < 4'000'000; ++i) {
+            numberProbes.push_back(i % 2 ? numberKeys[rng() % numberKeys.size()] : rng());
+        }
+        run("uint64", numbers, numberProbes);
+
+        UnorderedMap<std::string, int> strings;
+        for (size_t i = 0; i < size; ++i) {
+            strings["key-" + std::to_string(rng())] = static_cast<int>(i);
+        }
+        std::vector<std::string> stringKeys;
+        for (const auto& [key, value] : strings) {
+            stringKeys.push_back(key);
+        }
+        std::vector<std::string> stringProbes;
+        for (size_t i = 0; i < 2'000'000; ++i) {
+            stringProbes.push_back(i % 2 ? stringKeys[rng() % stringKeys.size()] : "key-" + std::to_string(rng()));
+        }
+        run("string", strings, stringProbes);
+    }
+}
@@ -0,0 +1,803 @@
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Open-addressing counterpart of UnorderedMap: slots live in one contiguous array and every
+ * slot has a 1-byte control tag in a parallel array. A tag is either one of the special values
+ * below or the low 7 bits of the key hash, so a probe compares 16 tags at once and touches the
+ * slot array only for candidates that already matched those 7 bits.
+ */
+template<class Key, class Value, class Hash = std::hash<Key>, class Equal = std::equal_to<Key>,
+         class Alloc = std::allocator<std::pair<const Key, Value>>>
+class FlatUnorderedMap {
+public:
+    using NodeType = std::pair<const Key, Value>;
+    using AllocTraits = std::allocator_traits<Alloc>;
+    using SlotAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<NodeType>;
+    using SlotAllocTraits = std::allocator_traits<SlotAlloc>;
+    using CtrlAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<int8_t>;
+    using CtrlAllocTraits = std::allocator_traits<CtrlAlloc>;
+
+private:
+    static constexpr int8_t kEmpty = -128;
+    static constexpr int8_t kDeleted = -2;
+    static constexpr int8_t kSentinel = -1;
+    static constexpr size_t kGroupWidth = 16;
+    static constexpr size_t kClonedBytes = kGroupWidth - 1;
+
+    struct Group;
+
+    SlotAlloc slot_alloc;
+    CtrlAlloc ctrl_alloc;
+    int8_t* ctrl;
+    NodeType* slots;
+    size_t capacity;
+    size_t sz;
+    size_t growth_left;
+    float _max_load_factor;
+    Hash hasher;
+    Equal comparator;
+
+public:
+    FlatUnorderedMap();
+    FlatUnorderedMap(const FlatUnorderedMap& flat_map);
+    FlatUnorderedMap(FlatUnorderedMap&& flat_map) noexcept;
+    FlatUnorderedMap& operator=(const FlatUnorderedMap& flat_map);
+    FlatUnorderedMap& operator=(FlatUnorderedMap&& flat_map) noexcept;
+    ~FlatUnorderedMap();
+
+    template<bool isConst>
+    struct common_iterator;
+
+    using Iterator = common_iterator<false>;
+    using ConstIterator = common_iterator<true>;
+
+    Iterator begin();
+    ConstIterator begin() const;
+    Iterator end();
+    ConstIterator end() const;
+    ConstIterator cbegin() const;
+    ConstIterator cend() const;
+
+    size_t bucket_count() const;
+    size_t size() const;
+    size_t max_size() const;
+    float load_factor() const;
+    float max_load_factor() const;
+    void max_load_factor(float ml);
+
+    Value& operator[](Key&& key);
+    Value& operator[](const Key& key);
+
+    Value& at(const Key& key);
+    const Value& at(const Key& key) const;
+
+    std::pair<Iterator, bool> insert(const NodeType& key_val);
+    std::pair<Iterator, bool> insert(NodeType&& key_val);
+
+    template<class InputIterator>
+    void insert(InputIterator begin,
+                InputIterator end);
+
+    template<class... Args>
+    std::pair<Iterator, bool> emplace(Args&&... args);
+
+    ConstIterator find(const Key& key) const;
+    Iterator find(const Key& key);
+
+    void erase(Iterator iter);
+    void erase(Iterator begin,
+               Iterator end);
+
+    void reserve(size_t new_size);
+
+private:
+    size_t mixHash(const Key& key) const;
+    static size_t probeStart(size_t hash);
+    static int8_t hashTag(size_t hash);
+    static size_t normalizeCapacity(size_t min_capacity);
+    size_t capacityToGrowth(size_t cap) const;
+
+    size_t findIndex(const Key& key,
+                     size_t hash) const;
+    size_t findFreeIndex(size_t hash) const;
+    void setCtrl(size_t index,
+                 int8_t tag);
+
+    std::pair<size_t, bool> findOrPrepareInsert(const Key& key);
+    size_t prepareInsert(size_t hash);
+    template<class... Args>
+    void constructSlot(size_t index,
+                       Args&&... args);
+
+    void resize(size_t new_capacity);
+    void rehashAndGrowIfNecessary();
+    void initializeCtrl();
+    void destroySlots();
+    void deallocateTable();
+    void copyFrom(const FlatUnorderedMap& flat_map);
+    void stealFrom(FlatUnorderedMap& flat_map) noexcept;
+    void eraseIndex(size_t index);
+    void releaseIndex(size_t index);
+};
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+struct FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::Group
+{
+#ifdef __SSE2__
+    __m128i ctrl;
+
+    explicit Group(const int8_t* pos) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {}
+
+    uint32_t match(int8_t tag) const {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(tag), ctrl)));
+    }
+
+    uint32_t matchEmpty() const {
+        return match(kEmpty);
+    }
+
+    uint32_t matchEmptyOrDeleted() const {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(kSentinel), ctrl)));
+    }
+#else
+    int8_t ctrl[kGroupWidth];
+
+    explicit Group(const int8_t* pos) {
+        std::memcpy(ctrl, pos, kGroupWidth);
+    }
+
+    uint32_t match(int8_t tag) const {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupWidth; ++i) {
+            mask |= static_cast<uint32_t>(ctrl[i] == tag) << i;
+        }
+        return mask;
+    }
+
+    uint32_t matchEmpty() const {
+        return match(kEmpty);
+    }
+
+    uint32_t matchEmptyOrDeleted() const {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupWidth; ++i) {
+            mask |= static_cast<uint32_t>(ctrl[i] < kSentinel) << i;
+        }
+        return mask;
+    }
+#endif
+};
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<bool isConst>
+struct FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator
+{
+private:
+    const int8_t* ctrl;
+    NodeType* slot;
+
+    void skipEmptyOrDeleted();
+
+public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = NodeType;
+    using pointer = std::conditional_t<isConst,
+                                       const NodeType*,
+                                       NodeType*>;
+    using reference = std::conditional_t<isConst,
+                                         const NodeType&,
+                                         NodeType&>;
+    using iterator_category = std::forward_iterator_tag;
+
+    common_iterator() = default;
+    common_iterator(const int8_t* ctrl,
+                    NodeType* slot);
+    common_iterator(const common_iterator& iter) = default;
+    common_iterator& operator=(const common_iterator& iter) = default;
+
+    decltype(auto) operator++();
+    decltype(auto) operator++(int);
+    reference operator*() const;
+    pointer operator->() const;
+    operator ConstIterator() const;
+
+    friend bool operator==(const common_iterator& first,
+                           const common_iterator& second) {
+        return first.ctrl == second.ctrl;
+    }
+    friend bool operator!=(const common_iterator& first,
+                           const common_iterator& second) {
+        return !(first == second);
+    }
+
+    friend class FlatUnorderedMap;
+};
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<bool isConst>
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::
+        common_iterator(const int8_t* ctrl,
+                        NodeType* slot) : ctrl(ctrl),
+                                          slot(slot) {}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<bool isConst>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::skipEmptyOrDeleted() {
+    while (*ctrl < kSentinel) {
+        ++ctrl;
+        ++slot;
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<bool isConst>
+decltype(auto) FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::
+operator++() {
+    ++ctrl;
+    ++slot;
+    skipEmptyOrDeleted();
+    return *this;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<bool isConst>
+decltype(auto) FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::
+operator++(int) {
+    auto return_it = *this;
+    ++*this;
+    return return_it;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<bool isConst>
+typename FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::template common_iterator<isConst>::reference
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::operator*() const {
+    return *slot;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<bool isConst>
+typename FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::template common_iterator<isConst>::pointer
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::operator->() const {
+    return slot;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<bool isConst>
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::
+operator ConstIterator() const {
+    return ConstIterator(ctrl, slot);
+}
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+typename FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::begin() {
+    if (capacity == 0) {
+        return end();
+    }
+    Iterator iter(ctrl, slots);
+    iter.skipEmptyOrDeleted();
+    return iter;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+typename FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::ConstIterator
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::begin() const {
+    return cbegin();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+typename FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::end() {
+    return Iterator(ctrl + capacity, slots + capacity);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+typename FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::ConstIterator
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::end() const {
+    return cend();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+typename FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::ConstIterator
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::cbegin() const {
+    return const_cast<FlatUnorderedMap*>(this)->begin();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+typename FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::ConstIterator
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::cend() const {
+    return const_cast<FlatUnorderedMap*>(this)->end();
+}
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::FlatUnorderedMap() : ctrl(nullptr),
+                                                                       slots(nullptr),
+                                                                       capacity(0),
+                                                                       sz(0),
+                                                                       growth_left(0),
+                                                                       _max_load_factor(0.875) {}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::FlatUnorderedMap(const FlatUnorderedMap& flat_map) : slot_alloc(SlotAllocTraits::select_on_container_copy_construction(flat_map.slot_alloc)),
+                                                                                                    ctrl_alloc(CtrlAllocTraits::select_on_container_copy_construction(flat_map.ctrl_alloc)),
+                                                                                                    ctrl(nullptr),
+                                                                                                    slots(nullptr),
+                                                                                                    capacity(0),
+                                                                                                    sz(0),
+                                                                                                    growth_left(0),
+                                                                                                    _max_load_factor(flat_map._max_load_factor),
+                                                                                                    hasher(flat_map.hasher),
+                                                                                                    comparator(flat_map.comparator) {
+    copyFrom(flat_map);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::FlatUnorderedMap(FlatUnorderedMap&& flat_map) noexcept : slot_alloc(std::move(flat_map.slot_alloc)),
+                                                                                                        ctrl_alloc(std::move(flat_map.ctrl_alloc)),
+                                                                                                        ctrl(nullptr),
+                                                                                                        slots(nullptr),
+                                                                                                        capacity(0),
+                                                                                                        sz(0),
+                                                                                                        growth_left(0),
+                                                                                                        _max_load_factor(flat_map._max_load_factor),
+                                                                                                        hasher(std::move(flat_map.hasher)),
+                                                                                                        comparator(std::move(flat_map.comparator)) {
+    stealFrom(flat_map);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>&
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::operator=(const FlatUnorderedMap& flat_map) {
+    if (this == &flat_map) return *this;
+    destroySlots();
+    deallocateTable();
+    if (AllocTraits::propagate_on_container_copy_assignment::value) {
+        slot_alloc = flat_map.slot_alloc;
+        ctrl_alloc = flat_map.ctrl_alloc;
+    }
+    _max_load_factor = flat_map._max_load_factor;
+    hasher = flat_map.hasher;
+    comparator = flat_map.comparator;
+    copyFrom(flat_map);
+    return *this;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>&
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::operator=(FlatUnorderedMap&& flat_map) noexcept {
+    if (this == &flat_map) return *this;
+    destroySlots();
+    deallocateTable();
+    if (AllocTraits::propagate_on_container_move_assignment::value) {
+        slot_alloc = std::move(flat_map.slot_alloc);
+        ctrl_alloc = std::move(flat_map.ctrl_alloc);
+    }
+    _max_load_factor = flat_map._max_load_factor;
+    hasher = std::move(flat_map.hasher);
+    comparator = std::move(flat_map.comparator);
+    stealFrom(flat_map);
+    return *this;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::~FlatUnorderedMap() {
+    destroySlots();
+    deallocateTable();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::copyFrom(const FlatUnorderedMap& flat_map) {
+    if (flat_map.sz == 0) {
+        return;
+    }
+    resize(normalizeCapacity(flat_map.sz / _max_load_factor + 1));
+    // A copy constructor never reaches the destructor if this throws, so clean up here.
+    try {
+        for (auto it = flat_map.begin(); it != flat_map.end(); ++it) {
+            size_t index = prepareInsert(mixHash(it->first));
+            constructSlot(index, *it);
+        }
+    } catch (...) {
+        destroySlots();
+        deallocateTable();
+        throw;
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::stealFrom(FlatUnorderedMap& flat_map) noexcept {
+    ctrl = std::exchange(flat_map.ctrl, nullptr);
+    slots = std::exchange(flat_map.slots, nullptr);
+    capacity = std::exchange(flat_map.capacity, 0);
+    sz = std::exchange(flat_map.sz, 0);
+    growth_left = std::exchange(flat_map.growth_left, 0);
+}
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::mixHash(const Key& key) const {
+    // Multiply-xorshift so that identity hashes (std::hash<int>) still spread over both
+    // the probe start bits and the 7 tag bits.
+    uint64_t hash = static_cast<uint64_t>(hasher(key)) * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::probeStart(size_t hash) {
+    return hash >> 7;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+int8_t FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::hashTag(size_t hash) {
+    return static_cast<int8_t>(hash & 0x7F);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::normalizeCapacity(size_t min_capacity) {
+    // Capacity is always 2^k - 1 so that it doubles as the probe mask.
+    return min_capacity <= kClonedBytes ? kClonedBytes : std::bit_ceil(min_capacity + 1) - 1;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::capacityToGrowth(size_t cap) const {
+    size_t growth = static_cast<size_t>(cap * _max_load_factor);
+    return growth < cap ? growth : cap - 1;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::setCtrl(size_t index,
+                                                               int8_t tag) {
+    ctrl[index] = tag;
+    ctrl[((index - kClonedBytes) & capacity) + (kClonedBytes & capacity)] = tag;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::findIndex(const Key& key,
+                                                                   size_t hash) const {
+    if (capacity == 0) {
+        return capacity;
+    }
+    int8_t tag = hashTag(hash);
+    size_t pos = probeStart(hash) & capacity;
+    size_t step = 0;
+    while (true) {
+        Group group(ctrl + pos);
+        for (uint32_t mask = group.match(tag); mask != 0; mask &= mask - 1) {
+            size_t index = (pos + std::countr_zero(mask)) & capacity;
+            if (comparator(slots[index].first, key)) {
+                return index;
+            }
+        }
+        if (group.matchEmpty() != 0) {
+            return capacity;
+        }
+        step += kGroupWidth;
+        pos = (pos + step) & capacity;
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::findFreeIndex(size_t hash) const {
+    size_t pos = probeStart(hash) & capacity;
+    size_t step = 0;
+    while (true) {
+        uint32_t mask = Group(ctrl + pos).matchEmptyOrDeleted();
+        if (mask != 0) {
+            return (pos + std::countr_zero(mask)) & capacity;
+        }
+        step += kGroupWidth;
+        pos = (pos + step) & capacity;
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::initializeCtrl() {
+    std::memset(ctrl, kEmpty, capacity + 1 + kClonedBytes);
+    ctrl[capacity] = kSentinel;
+    growth_left = capacityToGrowth(capacity) - sz;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::destroySlots() {
+    if constexpr (!std::is_trivially_destructible_v<NodeType>) {
+        for (size_t i = 0; i < capacity; ++i) {
+            if (ctrl[i] >= 0) {
+                SlotAllocTraits::destroy(slot_alloc, slots + i);
+            }
+        }
+    }
+    sz = 0;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::deallocateTable() {
+    if (capacity == 0) {
+        return;
+    }
+    CtrlAllocTraits::deallocate(ctrl_alloc, ctrl, capacity + 1 + kClonedBytes);
+    SlotAllocTraits::deallocate(slot_alloc, slots, capacity);
+    ctrl = nullptr;
+    slots = nullptr;
+    capacity = 0;
+    growth_left = 0;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::resize(size_t new_capacity) {
+    int8_t* old_ctrl = ctrl;
+    NodeType* old_slots = slots;
+    size_t old_capacity = capacity;
+    size_t old_sz = sz;
+    size_t old_growth_left = growth_left;
+
+    int8_t* new_ctrl = CtrlAllocTraits::allocate(ctrl_alloc, new_capacity + 1 + kClonedBytes);
+    try {
+        slots = SlotAllocTraits::allocate(slot_alloc, new_capacity);
+    } catch (...) {
+        CtrlAllocTraits::deallocate(ctrl_alloc, new_ctrl, new_capacity + 1 + kClonedBytes);
+        throw;
+    }
+    ctrl = new_ctrl;
+    capacity = new_capacity;
+    initializeCtrl();
+
+    // Moving a pair<const Key, Value> still copies the key, so elements are only moved when that
+    // cannot throw and copied otherwise. The old table then stays intact until every element is
+    // in the new one, and a throwing copy just drops the new table. As with std::unordered_map,
+    // a throwing hash function gives no such guarantee.
+    try {
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old_ctrl[i] >= 0) {
+                size_t hash = mixHash(old_slots[i].first);
+                size_t index = findFreeIndex(hash);
+                SlotAllocTraits::construct(slot_alloc, slots + index, std::move_if_noexcept(old_slots[i]));
+                setCtrl(index, hashTag(hash));
+            }
+        }
+    } catch (...) {
+        destroySlots();
+        deallocateTable();
+        ctrl = old_ctrl;
+        slots = old_slots;
+        capacity = old_capacity;
+        sz = old_sz;
+        growth_left = old_growth_left;
+        throw;
+    }
+    for (size_t i = 0; i < old_capacity; ++i) {
+        if (old_ctrl[i] >= 0) {
+            SlotAllocTraits::destroy(slot_alloc, old_slots + i);
+        }
+    }
+    if (old_capacity != 0) {
+        CtrlAllocTraits::deallocate(ctrl_alloc, old_ctrl, old_capacity + 1 + kClonedBytes);
+        SlotAllocTraits::deallocate(slot_alloc, old_slots, old_capacity);
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::rehashAndGrowIfNecessary() {
+    // A table whose growth budget went mostly to tombstones is rebuilt at the same size
+    // instead of doubling.
+    if (capacity > kClonedBytes && sz * 8 <= capacityToGrowth(capacity) * 7) {
+        resize(capacity);
+    } else {
+        resize(normalizeCapacity(capacity * 2 + 1));
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::prepareInsert(size_t hash) {
+    size_t index = findFreeIndex(hash);
+    if (growth_left == 0 && ctrl[index] != kDeleted) {
+        rehashAndGrowIfNecessary();
+        index = findFreeIndex(hash);
+    }
+    growth_left -= (ctrl[index] == kEmpty);
+    setCtrl(index, hashTag(hash));
+    ++sz;
+    return index;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<class... Args>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::constructSlot(size_t index,
+                                                                     Args&&... args) {
+    // prepareInsert() has already marked the slot full; give it back if the element throws.
+    try {
+        SlotAllocTraits::construct(slot_alloc, slots + index, std::forward<Args>(args)...);
+    } catch (...) {
+        releaseIndex(index);
+        throw;
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+std::pair<size_t, bool> FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::findOrPrepareInsert(const Key& key) {
+    if (capacity == 0) {
+        resize(kClonedBytes);
+    }
+    size_t hash = mixHash(key);
+    size_t index = findIndex(key, hash);
+    if (index != capacity) {
+        return {index, false};
+    }
+    return {prepareInsert(hash), true};
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::eraseIndex(size_t index) {
+    SlotAllocTraits::destroy(slot_alloc, slots + index);
+    releaseIndex(index);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::releaseIndex(size_t index) {
+    --sz;
+    // If the slot never sat inside a run of 16 full tags, no probe sequence can have walked
+    // past it, so it may become empty again instead of leaving a tombstone.
+    size_t index_before = (index - kGroupWidth) & capacity;
+    uint32_t empty_after = Group(ctrl + index).matchEmpty();
+    uint32_t empty_before = Group(ctrl + index_before).matchEmpty();
+    bool was_never_full = empty_before != 0 && empty_after != 0 &&
+                          static_cast<size_t>(std::countr_zero(empty_after) +
+                                              std::countl_zero(static_cast<uint16_t>(empty_before))) < kGroupWidth;
+    setCtrl(index, was_never_full ? kEmpty : kDeleted);
+    growth_left += was_never_full;
+}
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+Value& FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::operator[](const Key& key) {
+    auto [index, inserted] = findOrPrepareInsert(key);
+    if (inserted) {
+        constructSlot(index, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple());
+    }
+    return slots[index].second;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+Value& FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::operator[](Key&& key) {
+    auto [index, inserted] = findOrPrepareInsert(key);
+    if (inserted) {
+        constructSlot(index, std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple());
+    }
+    return slots[index].second;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+Value& FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::at(const Key& key) {
+    size_t index = findIndex(key, mixHash(key));
+    if (index == capacity) {
+        throw std::out_of_range("FlatUnorderedMap::at");
+    }
+    return slots[index].second;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+const Value& FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::at(const Key& key) const {
+    return const_cast<FlatUnorderedMap*>(this)->at(key);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+std::pair<typename FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator, bool>
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::insert(const NodeType& key_val) {
+    auto [index, inserted] = findOrPrepareInsert(key_val.first);
+    if (inserted) {
+        constructSlot(index, key_val);
+    }
+    return {Iterator(ctrl + index, slots + index), inserted};
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+std::pair<typename FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator, bool>
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::insert(NodeType&& key_val) {
+    auto [index, inserted] = findOrPrepareInsert(key_val.first);
+    if (inserted) {
+        constructSlot(index, std::move(key_val));
+    }
+    return {Iterator(ctrl + index, slots + index), inserted};
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<class InputIterator>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::insert(InputIterator begin,
+                                                              InputIterator end) {
+    for (auto it = begin; it != end; ++it) {
+        insert(*it);
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<class... Args>
+std::pair<typename FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator, bool>
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::emplace(Args&&... args) {
+    return insert(NodeType(std::forward<Args>(args)...));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+typename FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::ConstIterator
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::find(const Key& key) const {
+    return const_cast<FlatUnorderedMap*>(this)->find(key);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+typename FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator
+FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::find(const Key& key) {
+    size_t index = findIndex(key, mixHash(key));
+    return Iterator(ctrl + index, slots + index);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::erase(Iterator iter) {
+    eraseIndex(iter.ctrl - ctrl);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::erase(Iterator begin,
+                                                             Iterator end) {
+    while (begin != end) {
+        Iterator iter = begin;
+        ++begin;
+        erase(iter);
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::reserve(size_t new_size) {
+    size_t new_capacity = normalizeCapacity(new_size / _max_load_factor + 1);
+    if (new_capacity > capacity) {
+        resize(new_capacity);
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::bucket_count() const {
+    return capacity;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::size() const {
+    return sz;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::max_size() const {
+    return SlotAllocTraits::max_size(slot_alloc);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+float FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::load_factor() const {
+    return capacity == 0 ? 0 : static_cast<float>(sz) / capacity;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+float FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::max_load_factor() const {
+    return _max_load_factor;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void FlatUnorderedMap<Key, Value, Hash, Equal, Alloc>::max_load_factor(float ml) {
+    // Above 7/8 the probe sequences of a 16-wide group degrade quickly, so cap it there.
+    _max_load_factor = ml < 0.875f ? ml : 0.875f;
+    if (capacity != 0) {
+        size_t min_capacity = normalizeCapacity(sz / _max_load_factor + 1);
+        resize(min_capacity > capacity ? min_capacity : capacity);
+    }
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <optional>
+#include <utility>
+
+/*
+ * Minimal cooperative runtime for interleaving memory-bound lookups. A lookup coroutine issues a
+ * prefetch, then co_awaits InterleavedScheduler::yield() so that other lookups can issue theirs
+ * while the cache line is in flight; run() resumes the queued coroutines round-robin until all
+ * of them have finished.
+ *
+ * InterleavedTask<T> is the coroutine type for both lookups and the handlers that call them.
+ * Tasks start suspended. A top-level task is handed to spawn() and its result read with get()
+ * after run(); a task co_awaited from another task runs inline and resumes its caller when done.
+ *
+ * Every lookup costs a coroutine frame allocation and a few switches through run(), so this only
+ * pays off when the misses it hides are more expensive than that. When the keys are known up
+ * front, UnorderedMap::find_many() gets the same overlap without the bookkeeping.
+ *
+ * Everything runs on the thread that calls run(); nothing here is thread-safe.
+ */
+class InterleavedScheduler {
+public:
+    struct YieldAwaiter;
+
+    template<typename Task>
+    void spawn(Task& task);
+    void schedule(std::coroutine_handle<> handle);
+    YieldAwaiter yield();
+    void run();
+
+private:
+    std::deque<std::coroutine_handle<>> ready;
+};
+
+struct InterleavedScheduler::YieldAwaiter {
+    InterleavedScheduler* scheduler;
+
+    bool await_ready() const noexcept;
+    void await_suspend(std::coroutine_handle<> handle) const;
+    void await_resume() const noexcept;
+};
+
+inline bool InterleavedScheduler::YieldAwaiter::await_ready() const noexcept {
+    return false;
+}
+
+inline void InterleavedScheduler::YieldAwaiter::await_suspend(std::coroutine_handle<> handle) const {
+    scheduler->schedule(handle);
+}
+
+inline void InterleavedScheduler::YieldAwaiter::await_resume() const noexcept {}
+
+template<typename Task>
+void InterleavedScheduler::spawn(Task& task) {
+    schedule(task.handle);
+}
+
+inline void InterleavedScheduler::schedule(std::coroutine_handle<> handle) {
+    ready.push_back(handle);
+}
+
+inline InterleavedScheduler::YieldAwaiter InterleavedScheduler::yield() {
+    return YieldAwaiter{this};
+}
+
+inline void InterleavedScheduler::run() {
+    while (!ready.empty()) {
+        std::coroutine_handle<> handle = ready.front();
+        ready.pop_front();
+        handle.resume();
+    }
+}
+
+
+template<typename T>
+class InterleavedTask {
+public:
+    struct promise_type;
+
+    explicit InterleavedTask(std::coroutine_handle<promise_type> handle);
+    InterleavedTask(InterleavedTask&& task) noexcept;
+    InterleavedTask(const InterleavedTask&) = delete;
+    InterleavedTask& operator=(const InterleavedTask&) = delete;
+    ~InterleavedTask();
+
+    bool done() const;
+    T& get();
+
+    bool await_ready() const noexcept;
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller);
+    T await_resume();
+
+private:
+    std::coroutine_handle<promise_type> handle;
+
+    friend class InterleavedScheduler;
+};
+
+template<typename T>
+struct InterleavedTask<T>::promise_type {
+    std::optional<T> value;
+    std::exception_ptr exception;
+    std::coroutine_handle<> continuation; // the awaiting task, or null for a spawned one
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept {
+            return false;
+        }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) const noexcept {
+            std::coroutine_handle<> continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    InterleavedTask get_return_object() {
+        return InterleavedTask(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+    FinalAwaiter final_suspend() const noexcept {
+        return {};
+    }
+    template<typename U>
+    void return_value(U&& result) {
+        value.emplace(std::forward<U>(result));
+    }
+    void unhandled_exception() {
+        exception = std::current_exception();
+    }
+};
+
+template<typename T>
+InterleavedTask<T>::InterleavedTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+template<typename T>
+InterleavedTask<T>::InterleavedTask(InterleavedTask&& task) noexcept : handle(std::exchange(task.handle, nullptr)) {}
+
+template<typename T>
+InterleavedTask<T>::~InterleavedTask() {
+    if (handle) {
+        handle.destroy();
+    }
+}
+
+template<typename T>
+bool InterleavedTask<T>::done() const {
+    return handle.done();
+}
+
+template<typename T>
+T& InterleavedTask<T>::get() {
+    if (handle.promise().exception) {
+        std::rethrow_exception(handle.promise().exception);
+    }
+    return *handle.promise().value;
+}
+
+template<typename T>
+bool InterleavedTask<T>::await_ready() const noexcept {
+    return false;
+}
+
+template<typename T>
+std::coroutine_handle<> InterleavedTask<T>::await_suspend(std::coroutine_handle<> caller) {
+    // Start the awaited task right away; its final suspend hands control back to caller.
+    handle.promise().continuation = caller;
+    return handle;
+}
+
+template<typename T>
+T InterleavedTask<T>::await_resume() {
+    return std::move(get());
+}
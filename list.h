@@ -1,4 +1,5 @@
 #include <memory>
+#include <memory_resource>
 #include <type_traits>
 #include <iterator>
 #include <new>
@@ -45,10 +46,14 @@ public:
     List(List&& list) noexcept;
     ~List();
     List& operator=(const List& list);
-    List& operator=(List&& list) noexcept;
+    List& operator=(List&& list) noexcept(AllocTraits::propagate_on_container_move_assignment::value ||
+                                          AllocTraits::is_always_equal::value);
+
+    void swap(List& list) noexcept;
 
     decltype(auto) get_allocator() const;
     size_t size() const;
+    void clear();
 
     template<typename U>
     void push_back(U&& value);
@@ -66,16 +71,15 @@ public:
 
     iterator erase(const_iterator pos);
 private:
-    Allocator alloc;
-    BaseNodeAlloc base_node_alloc;
-    NodeAlloc node_alloc;
-    TAlloc t_alloc;
+    Allocator alloc; // the node, base-node and element allocators are rebound from it on use
     size_t sz;
-    BaseNode* basic;
+    BaseNode sentinel; // lives in the list object, so creating or moving a list allocates nothing
+    BaseNode* basic = &sentinel;
     void createBasic();
     void moveBasic(List&& list);
     void copyList(const List& list);
     void moveList(List& list) noexcept;
+    void moveElements(List& list);
     void checkPropagateOnContainerCopyAssignment(const List& list);
     void popAllNodes();
     void pop(BaseNode* deleting_node);
@@ -103,7 +107,6 @@ struct List<T, Allocator>::BaseNode {
     BaseNode* next;
     BaseNode(BaseNode* prev, BaseNode* next);
     BaseNode() = default;
-    virtual ~BaseNode() = default;
 };
 
 template<typename T, typename Allocator>
@@ -112,7 +115,6 @@ List<T, Allocator>::BaseNode::BaseNode(BaseNode* prev, BaseNode* next) : prev(pr
 template<typename T, typename Allocator>
 struct List<T, Allocator>::Node : public List<T, Allocator>::BaseNode {
     T value;
-    virtual ~Node() = default;
 };
 
 
@@ -309,19 +311,16 @@ typename List<T, Allocator>::const_reverse_iterator List<T, Allocator>::crend()
 
 template<typename T, typename Allocator>
 void List<T, Allocator>::createBasic() {
-    basic = BaseNodeAllocTraits::allocate(base_node_alloc, 1);
-    BaseNodeAllocTraits::construct(base_node_alloc, basic, basic, basic);
+    basic->prev = basic->next = basic;
 }
 
 template<typename T, typename Allocator>
-List<T, Allocator>::List(const Allocator& alloc) : alloc(alloc), base_node_alloc(alloc),
-node_alloc(alloc), t_alloc(alloc), sz(0) {
+List<T, Allocator>::List(const Allocator& alloc) : alloc(alloc), sz(0) {
     createBasic();
 }
 
 template<typename T, typename Allocator>
-List<T, Allocator>::List(size_t count, const T& value, const Allocator& alloc) : alloc(alloc),
-base_node_alloc(alloc), node_alloc(alloc), t_alloc(alloc), sz(0) {
+List<T, Allocator>::List(size_t count, const T& value, const Allocator& alloc) : alloc(alloc), sz(0) {
     createBasic();
     for (size_t i = 0; i < count; ++i) {
         push_back(value);
@@ -329,8 +328,7 @@ base_node_alloc(alloc), node_alloc(alloc), t_alloc(alloc), sz(0) {
 }
 
 template<typename T, typename Allocator>
-List<T, Allocator>::List(size_t count, const Allocator& alloc) : alloc(alloc),
-base_node_alloc(alloc), node_alloc(alloc), t_alloc(alloc), sz(0) {
+List<T, Allocator>::List(size_t count, const Allocator& alloc) : alloc(alloc), sz(0) {
     createBasic();
     for (size_t i = 0; i < count; ++i) {
         push_back();
@@ -345,58 +343,60 @@ decltype(auto) List<T, Allocator>::get_allocator() const {
 template<typename T, typename Allocator>
 void List<T, Allocator>::copyList(const List& list) {
     Node* list_node = reinterpret_cast<Node*>(list.basic->next);
-    for(size_t i = 0; i < list.sz - 1; ++i) {
+    for(size_t i = 0; i < list.sz; ++i) {
         push_back(list_node->value);
         list_node = reinterpret_cast<Node*>(list_node->next);
     }
-    push_back(list_node->value);
 }
 
 template<typename T, typename Allocator>
 void List<T, Allocator>::moveList(List& list) noexcept {
+    if(list.sz == 0) return;
     basic->prev = list.basic->prev;
     basic->next = list.basic->next;
-    list.basic->prev = list.basic->next = nullptr;
+    basic->prev->next = basic->next->prev = basic;
+    list.basic->prev = list.basic->next = list.basic;
     list.sz = 0;
 }
 
 template<typename T, typename Allocator>
 List<T, Allocator>::List(const List& list) :
-alloc(AllocTraits::select_on_container_copy_construction(list.alloc)),
-base_node_alloc(BaseNodeAllocTraits::select_on_container_copy_construction(list.base_node_alloc)),
-node_alloc(NodeAllocTraits::select_on_container_copy_construction(list.node_alloc)),
-t_alloc(TAllocTraits::select_on_container_copy_construction(list.t_alloc)),
-sz(0) {
+alloc(AllocTraits::select_on_container_copy_construction(list.alloc)), sz(0) {
     createBasic();
     copyList(list);
 }
 
 template<typename T, typename Allocator>
-List<T, Allocator>::List(List&& list) noexcept :
-alloc(AllocTraits::select_on_container_copy_construction(list.alloc)),
-base_node_alloc(BaseNodeAllocTraits::select_on_container_copy_construction(list.base_node_alloc)),
-node_alloc(NodeAllocTraits::select_on_container_copy_construction(list.node_alloc)),
-t_alloc(TAllocTraits::select_on_container_copy_construction(list.t_alloc)),
-sz(list.sz) {
+List<T, Allocator>::List(List&& list) noexcept : alloc(list.alloc), sz(list.sz) {
     createBasic();
     moveList(list);
 }
 
 template<typename T, typename Allocator>
 void List<T, Allocator>::popAllNodes() {
-    size_t old_size = sz;
-    for(size_t i = 0; i < old_size; ++i) {
-        pop_back();
+    // Every node goes, so none of them is unlinked from its neighbours one by one.
+    TAlloc t_alloc(alloc);
+    NodeAlloc node_alloc(alloc);
+    BaseNode* node = basic->next;
+    while (node != basic) {
+        BaseNode* next = node->next;
+        TAllocTraits::destroy(t_alloc, &(reinterpret_cast<Node*>(node)->value));
+        NodeAllocTraits::deallocate(node_alloc, reinterpret_cast<Node*>(node), 1);
+        node = next;
     }
+    createBasic();
+    sz = 0;
+}
+
+template<typename T, typename Allocator>
+void List<T, Allocator>::clear() {
+    popAllNodes();
 }
 
 template<typename T, typename Allocator>
 void List<T, Allocator>::checkPropagateOnContainerCopyAssignment(const List& list) {
-    if (AllocTraits::propagate_on_container_copy_assignment::value && alloc != list.get_allocator()) {
-        alloc = list.get_allocator();
-        base_node_alloc = list.base_node_alloc;
-        node_alloc = list.node_alloc;
-        t_alloc = list.t_alloc;
+    if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+        alloc = list.alloc;
     }
 }
 
@@ -410,20 +410,59 @@ List<T, Allocator>& List<T, Allocator>::operator=(const List& list) {
 }
 
 template<typename T, typename Allocator>
-List<T, Allocator>& List<T, Allocator>::operator=(List&& list) noexcept {
+List<T, Allocator>& List<T, Allocator>::operator=(List&& list)
+        noexcept(AllocTraits::propagate_on_container_move_assignment::value || AllocTraits::is_always_equal::value) {
     if(this == &list) return *this;
     popAllNodes();
-    checkPropagateOnContainerCopyAssignment(list);
+    if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+        alloc = list.alloc;
+    } else if (alloc != list.alloc) {
+        // The nodes belong to a different memory resource and cannot be adopted.
+        moveElements(list);
+        return *this;
+    }
     sz = list.sz;
     moveList(list);
     return *this;
 }
 
+template<typename T, typename Allocator>
+void List<T, Allocator>::moveElements(List& list) {
+    for (BaseNode* list_node = list.basic->next; list_node != list.basic; list_node = list_node->next) {
+        push_back(std::move(reinterpret_cast<Node*>(list_node)->value));
+    }
+    list.popAllNodes();
+}
+
+template<typename T, typename Allocator>
+void List<T, Allocator>::swap(List& list) noexcept {
+    if constexpr (AllocTraits::propagate_on_container_swap::value) {
+        std::swap(alloc, list.alloc);
+    }
+    // The sentinels stay put, so swap what they link to and point the end nodes back at them.
+    std::swap(basic->prev, list.basic->prev);
+    std::swap(basic->next, list.basic->next);
+    std::swap(sz, list.sz);
+    if (sz == 0) {
+        createBasic();
+    } else {
+        basic->next->prev = basic->prev->next = basic;
+    }
+    if (list.sz == 0) {
+        list.createBasic();
+    } else {
+        list.basic->next->prev = list.basic->prev->next = list.basic;
+    }
+}
+
+template<typename T, typename Allocator>
+void swap(List<T, Allocator>& left, List<T, Allocator>& right) noexcept {
+    left.swap(right);
+}
+
 template<typename T, typename Allocator>
 List<T, Allocator>::~List() {
     popAllNodes();
-    BaseNodeAllocTraits::destroy(base_node_alloc, basic);
-    BaseNodeAllocTraits::deallocate(base_node_alloc, basic, 1);
 }
 
 template<typename T, typename Allocator>
@@ -439,8 +478,9 @@ void List<T, Allocator>::pop(BaseNode* deleting_node) {
         deleting_node->prev->next = deleting_node->next;
         deleting_node->next->prev = deleting_node->prev;
     }
+    TAlloc t_alloc(alloc);
+    NodeAlloc node_alloc(alloc);
     TAllocTraits::destroy(t_alloc, &(reinterpret_cast<Node*>(deleting_node)->value));
-    BaseNodeAllocTraits::destroy(base_node_alloc, deleting_node);
     NodeAllocTraits::deallocate(node_alloc, reinterpret_cast<Node*>(deleting_node), 1);
     --sz;
 }
@@ -448,6 +488,9 @@ void List<T, Allocator>::pop(BaseNode* deleting_node) {
 template<typename T, typename Allocator>
 template<typename U>
 typename List<T, Allocator>::BaseNode* List<T, Allocator>::push(BaseNode* pos, U&& value) {
+    NodeAlloc node_alloc(alloc);
+    BaseNodeAlloc base_node_alloc(alloc);
+    TAlloc t_alloc(alloc);
     BaseNode* node = NodeAllocTraits::allocate(node_alloc, 1);
     BaseNodeAllocTraits::construct(base_node_alloc, node, pos->prev, pos);
     TAllocTraits::construct(t_alloc, &(reinterpret_cast<Node*>(node)->value),
@@ -459,6 +502,9 @@ typename List<T, Allocator>::BaseNode* List<T, Allocator>::push(BaseNode* pos, U
 
 template<typename T, typename Allocator>
 typename List<T, Allocator>::BaseNode* List<T, Allocator>::push(BaseNode* pos) {
+    NodeAlloc node_alloc(alloc);
+    BaseNodeAlloc base_node_alloc(alloc);
+    TAlloc t_alloc(alloc);
     BaseNode* node = NodeAllocTraits::allocate(node_alloc, 1);
     BaseNodeAllocTraits::construct(base_node_alloc, node, pos->prev, pos);
     TAllocTraits::construct(t_alloc, &(reinterpret_cast<Node*>(node)->value));
@@ -507,4 +553,9 @@ typename List<T, Allocator>::iterator List<T, Allocator>::erase(const_iterator p
     ++pos;
     pop(deleting_node);
     return iterator(pos.node);
-}
\ No newline at end of file
+}
+
+namespace pmr {
+template<typename T>
+using List = ::List<T, std::pmr::polymorphic_allocator<T>>;
+}
@@ -0,0 +1,201 @@
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Fixed-size node pool shared by every PoolAllocator rebound from the same allocator. Requests
+ * up to kMaxPooledSize bytes are rounded up to a multiple of kGranularity and carved out of
+ * kSlabSize-byte slabs; freed blocks go onto an intrusive free list for their size class and are
+ * handed out again before the slab is touched. Slabs are only given back when the resource dies,
+ * i.e. when the last allocator (and so the last container) using it is destroyed. Larger or
+ * over-aligned requests, such as grown bucket arrays, go straight to operator new.
+ *
+ * Not thread-safe: one resource must not be used from several threads at once.
+ */
+class PoolResource {
+public:
+    static constexpr size_t kGranularity = alignof(std::max_align_t);
+    static constexpr size_t kMaxPooledSize = 256;
+    static constexpr size_t kSlabSize = 64 * 1024;
+
+    PoolResource() = default;
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+    ~PoolResource();
+
+    void* allocate(size_t bytes,
+                   size_t alignment);
+    void deallocate(void* pointer,
+                    size_t bytes,
+                    size_t alignment);
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct SizeClass
+    {
+        FreeBlock* free_list = nullptr;
+        char* cursor = nullptr;
+        char* slab_end = nullptr;
+    };
+
+    SizeClass size_classes[kMaxPooledSize / kGranularity];
+    std::vector<void*> slabs;
+
+    static bool isPooled(size_t bytes,
+                         size_t alignment);
+    static size_t sizeClassIndex(size_t bytes);
+    void addSlab(SizeClass& size_class);
+};
+
+inline PoolResource::~PoolResource() {
+    for (void* slab : slabs) {
+        ::operator delete(slab);
+    }
+}
+
+inline bool PoolResource::isPooled(size_t bytes,
+                                   size_t alignment) {
+    return bytes != 0 && bytes <= kMaxPooledSize && alignment <= kGranularity;
+}
+
+inline size_t PoolResource::sizeClassIndex(size_t bytes) {
+    return (bytes + kGranularity - 1) / kGranularity - 1;
+}
+
+inline void PoolResource::addSlab(SizeClass& size_class) {
+    slabs.reserve(slabs.size() + 1);
+    char* slab = static_cast<char*>(::operator new(kSlabSize));
+    slabs.push_back(slab);
+    size_class.cursor = slab;
+    size_class.slab_end = slab + kSlabSize;
+}
+
+inline void* PoolResource::allocate(size_t bytes,
+                                    size_t alignment) {
+    if (!isPooled(bytes, alignment)) {
+        if (alignment > kGranularity) {
+            return ::operator new(bytes, std::align_val_t(alignment));
+        }
+        return ::operator new(bytes);
+    }
+    size_t index = sizeClassIndex(bytes);
+    SizeClass& size_class = size_classes[index];
+    if (size_class.free_list != nullptr) {
+        FreeBlock* block = size_class.free_list;
+        size_class.free_list = block->next;
+        return block;
+    }
+    size_t block_size = (index + 1) * kGranularity;
+    if (static_cast<size_t>(size_class.slab_end - size_class.cursor) < block_size) {
+        addSlab(size_class);
+    }
+    void* block = size_class.cursor;
+    size_class.cursor += block_size;
+    return block;
+}
+
+inline void PoolResource::deallocate(void* pointer,
+                                     size_t bytes,
+                                     size_t alignment) {
+    if (!isPooled(bytes, alignment)) {
+        if (alignment > kGranularity) {
+            ::operator delete(pointer, std::align_val_t(alignment));
+        } else {
+            ::operator delete(pointer);
+        }
+        return;
+    }
+    SizeClass& size_class = size_classes[sizeClassIndex(bytes)];
+    size_class.free_list = ::new (pointer) FreeBlock{size_class.free_list};
+}
+
+
+/*
+ * Allocator front end for PoolResource, usable as the Alloc parameter of List, ForwardList and
+ * UnorderedMap. A default-constructed allocator owns a fresh resource; copies and rebinds share
+ * it, so a container and all of its rebound node/bucket allocators draw from the same slabs.
+ * The allocator propagates on move and swap, so nodes never outlive the resource they were
+ * carved from. A copy never shares the resource: a copy-constructed container gets a fresh one
+ * and a copy-assigned container keeps its own, since the resource is not thread-safe and a copy
+ * is often handed to another thread.
+ */
+template<typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    PoolAllocator();
+    explicit PoolAllocator(std::shared_ptr<PoolResource> resource);
+    PoolAllocator(const PoolAllocator& other) = default;
+
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>& other);
+
+    PoolAllocator& operator=(const PoolAllocator& other) = default;
+
+    PoolAllocator select_on_container_copy_construction() const;
+
+    T* allocate(size_t n);
+    void deallocate(T* pointer,
+                    size_t n);
+
+    const std::shared_ptr<PoolResource>& resource() const;
+
+    template<typename U>
+    friend bool operator==(const PoolAllocator& left,
+                           const PoolAllocator<U>& right) {
+        return left.resource() == right.resource();
+    }
+    template<typename U>
+    friend bool operator!=(const PoolAllocator& left,
+                           const PoolAllocator<U>& right) {
+        return !(left == right);
+    }
+
+private:
+    std::shared_ptr<PoolResource> pool;
+};
+
+template<typename T>
+PoolAllocator<T>::PoolAllocator() : pool(std::make_shared<PoolResource>()) {}
+
+template<typename T>
+PoolAllocator<T>::PoolAllocator(std::shared_ptr<PoolResource> resource) : pool(std::move(resource)) {}
+
+template<typename T>
+template<typename U>
+PoolAllocator<T>::PoolAllocator(const PoolAllocator<U>& other) : pool(other.resource()) {}
+
+template<typename T>
+PoolAllocator<T> PoolAllocator<T>::select_on_container_copy_construction() const {
+    return PoolAllocator();
+}
+
+template<typename T>
+T* PoolAllocator<T>::allocate(size_t n) {
+    if (n > static_cast<size_t>(-1) / sizeof(T)) {
+        throw std::bad_array_new_length();
+    }
+    return static_cast<T*>(pool->allocate(n * sizeof(T), alignof(T)));
+}
+
+template<typename T>
+void PoolAllocator<T>::deallocate(T* pointer,
+                                  size_t n) {
+    pool->deallocate(pointer, n * sizeof(T), alignof(T));
+}
+
+template<typename T>
+const std::shared_ptr<PoolResource>& PoolAllocator<T>::resource() const {
+    return pool;
+}
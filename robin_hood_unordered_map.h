@@ -0,0 +1,811 @@
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Robin Hood open addressing: linear probing where every slot remembers how far it sits from
+ * its home bucket. Inserts keep each probe run sorted by home bucket, so a lookup stops as soon
+ * as it meets a slot closer to home than itself, and erase shifts the rest of the run back by
+ * one slot instead of leaving a tombstone.
+ *
+ * Erasing moves elements, so it invalidates iterators to elements after the erased one.
+ * Moving a pair<const Key, Value> copies the key; if that copy throws while erase() shifts a
+ * run back, the map stays valid but drops the elements of the run that the gap cut off.
+ */
+template<class Key, class Value, class Hash = std::hash<Key>, class Equal = std::equal_to<Key>,
+         class Alloc = std::allocator<std::pair<const Key, Value>>>
+class RobinHoodUnorderedMap {
+public:
+    using NodeType = std::pair<const Key, Value>;
+    using AllocTraits = std::allocator_traits<Alloc>;
+    using SlotAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<NodeType>;
+    using SlotAllocTraits = std::allocator_traits<SlotAlloc>;
+    using DistAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<uint16_t>;
+    using DistAllocTraits = std::allocator_traits<DistAlloc>;
+
+private:
+    // dist[i] is the probe length of slot i plus one; zero marks an empty slot.
+    static constexpr uint16_t kEmpty = 0;
+    static constexpr uint16_t kMaxDist = 0xFFFF;
+    static constexpr size_t kMinCapacity = 8;
+
+    SlotAlloc slot_alloc;
+    DistAlloc dist_alloc;
+    uint16_t* dist;
+    NodeType* slots;
+    size_t capacity;
+    size_t shift;
+    size_t sz;
+    float _max_load_factor;
+    Hash hasher;
+    Equal comparator;
+
+public:
+    RobinHoodUnorderedMap();
+    RobinHoodUnorderedMap(const RobinHoodUnorderedMap& robin_hood_map);
+    RobinHoodUnorderedMap(RobinHoodUnorderedMap&& robin_hood_map) noexcept;
+    RobinHoodUnorderedMap& operator=(const RobinHoodUnorderedMap& robin_hood_map);
+    RobinHoodUnorderedMap& operator=(RobinHoodUnorderedMap&& robin_hood_map) noexcept;
+    ~RobinHoodUnorderedMap();
+
+    template<bool isConst>
+    struct common_iterator;
+
+    using Iterator = common_iterator<false>;
+    using ConstIterator = common_iterator<true>;
+
+    Iterator begin();
+    ConstIterator begin() const;
+    Iterator end();
+    ConstIterator end() const;
+    ConstIterator cbegin() const;
+    ConstIterator cend() const;
+
+    size_t bucket_count() const;
+    size_t size() const;
+    size_t max_size() const;
+    float load_factor() const;
+    float max_load_factor() const;
+    void max_load_factor(float ml);
+    size_t max_probe_length() const;
+
+    Value& operator[](Key&& key);
+    Value& operator[](const Key& key);
+
+    Value& at(const Key& key);
+    const Value& at(const Key& key) const;
+
+    std::pair<Iterator, bool> insert(const NodeType& key_val);
+    std::pair<Iterator, bool> insert(NodeType&& key_val);
+
+    template<class InputIterator>
+    void insert(InputIterator begin,
+                InputIterator end);
+
+    template<class... Args>
+    std::pair<Iterator, bool> emplace(Args&&... args);
+
+    ConstIterator find(const Key& key) const;
+    Iterator find(const Key& key);
+
+    void erase(Iterator iter);
+    void erase(Iterator begin,
+               Iterator end);
+
+    void reserve(size_t new_size);
+
+private:
+    size_t homeIndex(const Key& key) const;
+    size_t findIndex(const Key& key) const;
+    std::pair<size_t, bool> findOrPrepareInsert(const Key& key);
+    size_t prepareInsert(size_t home);
+    template<class... Args>
+    void constructSlot(size_t index,
+                       Args&&... args);
+    bool shiftUp(size_t from,
+                 size_t to);
+    size_t eraseIndex(size_t index);
+    size_t releaseIndex(size_t index);
+    void dropUnreachable(size_t hole);
+
+    void resize(size_t new_capacity);
+    void allocateTable(size_t new_capacity);
+    void destroySlots();
+    void deallocateTable();
+    void copyFrom(const RobinHoodUnorderedMap& robin_hood_map);
+    void stealFrom(RobinHoodUnorderedMap& robin_hood_map) noexcept;
+};
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<bool isConst>
+struct RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator
+{
+private:
+    const uint16_t* dist;
+    NodeType* slot;
+
+    void skipEmpty();
+
+public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = NodeType;
+    using pointer = std::conditional_t<isConst,
+                                       const NodeType*,
+                                       NodeType*>;
+    using reference = std::conditional_t<isConst,
+                                         const NodeType&,
+                                         NodeType&>;
+    using iterator_category = std::forward_iterator_tag;
+
+    common_iterator() = default;
+    common_iterator(const uint16_t* dist,
+                    NodeType* slot);
+    common_iterator(const common_iterator& iter) = default;
+    common_iterator& operator=(const common_iterator& iter) = default;
+
+    decltype(auto) operator++();
+    decltype(auto) operator++(int);
+    reference operator*() const;
+    pointer operator->() const;
+    operator ConstIterator() const;
+
+    friend bool operator==(const common_iterator& first,
+                           const common_iterator& second) {
+        return first.dist == second.dist;
+    }
+    friend bool operator!=(const common_iterator& first,
+                           const common_iterator& second) {
+        return !(first == second);
+    }
+
+    friend class RobinHoodUnorderedMap;
+};
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<bool isConst>
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::
+        common_iterator(const uint16_t* dist,
+                        NodeType* slot) : dist(dist),
+                                          slot(slot) {}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<bool isConst>
+void RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::skipEmpty() {
+    while (*dist == kEmpty) {
+        ++dist;
+        ++slot;
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<bool isConst>
+decltype(auto) RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::
+operator++() {
+    ++dist;
+    ++slot;
+    skipEmpty();
+    return *this;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<bool isConst>
+decltype(auto) RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::
+operator++(int) {
+    auto return_it = *this;
+    ++*this;
+    return return_it;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<bool isConst>
+typename RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::template common_iterator<isConst>::reference
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::operator*() const {
+    return *slot;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<bool isConst>
+typename RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::template common_iterator<isConst>::pointer
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::operator->() const {
+    return slot;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<bool isConst>
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::
+operator ConstIterator() const {
+    return ConstIterator(dist, slot);
+}
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+typename RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::begin() {
+    if (capacity == 0) {
+        return end();
+    }
+    Iterator iter(dist, slots);
+    iter.skipEmpty();
+    return iter;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+typename RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::ConstIterator
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::begin() const {
+    return cbegin();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+typename RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::end() {
+    return Iterator(dist + capacity, slots + capacity);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+typename RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::ConstIterator
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::end() const {
+    return cend();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+typename RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::ConstIterator
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::cbegin() const {
+    return const_cast<RobinHoodUnorderedMap*>(this)->begin();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+typename RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::ConstIterator
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::cend() const {
+    return const_cast<RobinHoodUnorderedMap*>(this)->end();
+}
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::RobinHoodUnorderedMap() : dist(nullptr),
+                                                                                 slots(nullptr),
+                                                                                 capacity(0),
+                                                                                 shift(64),
+                                                                                 sz(0),
+                                                                                 _max_load_factor(0.8) {}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::RobinHoodUnorderedMap(const RobinHoodUnorderedMap& robin_hood_map) : slot_alloc(SlotAllocTraits::select_on_container_copy_construction(robin_hood_map.slot_alloc)),
+                                                                                                                         dist_alloc(DistAllocTraits::select_on_container_copy_construction(robin_hood_map.dist_alloc)),
+                                                                                                                         dist(nullptr),
+                                                                                                                         slots(nullptr),
+                                                                                                                         capacity(0),
+                                                                                                                         shift(64),
+                                                                                                                         sz(0),
+                                                                                                                         _max_load_factor(robin_hood_map._max_load_factor),
+                                                                                                                         hasher(robin_hood_map.hasher),
+                                                                                                                         comparator(robin_hood_map.comparator) {
+    copyFrom(robin_hood_map);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::RobinHoodUnorderedMap(RobinHoodUnorderedMap&& robin_hood_map) noexcept : slot_alloc(std::move(robin_hood_map.slot_alloc)),
+                                                                                                                             dist_alloc(std::move(robin_hood_map.dist_alloc)),
+                                                                                                                             dist(nullptr),
+                                                                                                                             slots(nullptr),
+                                                                                                                             capacity(0),
+                                                                                                                             shift(64),
+                                                                                                                             sz(0),
+                                                                                                                             _max_load_factor(robin_hood_map._max_load_factor),
+                                                                                                                             hasher(std::move(robin_hood_map.hasher)),
+                                                                                                                             comparator(std::move(robin_hood_map.comparator)) {
+    stealFrom(robin_hood_map);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>&
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::operator=(const RobinHoodUnorderedMap& robin_hood_map) {
+    if (this == &robin_hood_map) return *this;
+    destroySlots();
+    deallocateTable();
+    if (AllocTraits::propagate_on_container_copy_assignment::value) {
+        slot_alloc = robin_hood_map.slot_alloc;
+        dist_alloc = robin_hood_map.dist_alloc;
+    }
+    _max_load_factor = robin_hood_map._max_load_factor;
+    hasher = robin_hood_map.hasher;
+    comparator = robin_hood_map.comparator;
+    copyFrom(robin_hood_map);
+    return *this;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>&
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::operator=(RobinHoodUnorderedMap&& robin_hood_map) noexcept {
+    if (this == &robin_hood_map) return *this;
+    destroySlots();
+    deallocateTable();
+    if (AllocTraits::propagate_on_container_move_assignment::value) {
+        slot_alloc = std::move(robin_hood_map.slot_alloc);
+        dist_alloc = std::move(robin_hood_map.dist_alloc);
+    }
+    _max_load_factor = robin_hood_map._max_load_factor;
+    hasher = std::move(robin_hood_map.hasher);
+    comparator = std::move(robin_hood_map.comparator);
+    stealFrom(robin_hood_map);
+    return *this;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::~RobinHoodUnorderedMap() {
+    destroySlots();
+    deallocateTable();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::copyFrom(const RobinHoodUnorderedMap& robin_hood_map) {
+    if (robin_hood_map.sz == 0) {
+        return;
+    }
+    allocateTable(robin_hood_map.capacity);
+    // A copy constructor never reaches the destructor if this throws, so clean up here.
+    try {
+        for (auto it = robin_hood_map.begin(); it != robin_hood_map.end(); ++it) {
+            size_t index = prepareInsert(homeIndex(it->first));
+            constructSlot(index, *it);
+        }
+    } catch (...) {
+        destroySlots();
+        deallocateTable();
+        throw;
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::stealFrom(RobinHoodUnorderedMap& robin_hood_map) noexcept {
+    dist = std::exchange(robin_hood_map.dist, nullptr);
+    slots = std::exchange(robin_hood_map.slots, nullptr);
+    capacity = std::exchange(robin_hood_map.capacity, 0);
+    shift = std::exchange(robin_hood_map.shift, 64);
+    sz = std::exchange(robin_hood_map.sz, 0);
+}
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::homeIndex(const Key& key) const {
+    // Fibonacci hashing: the high bits of the product depend on every bit of the hash.
+    return static_cast<size_t>((static_cast<uint64_t>(hasher(key)) * 0x9E3779B97F4A7C15ull) >> shift);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::findIndex(const Key& key) const {
+    if (capacity == 0) {
+        return capacity;
+    }
+    size_t mask = capacity - 1;
+    size_t index = homeIndex(key);
+    for (uint16_t probe = 1; probe <= dist[index]; ++probe) {
+        if (dist[index] == probe && comparator(slots[index].first, key)) {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+    return capacity;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+bool RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::shiftUp(size_t from,
+                                                                    size_t to) {
+    // Moves the run [from, to) one slot to the right; slot `to` must be empty.
+    size_t mask = capacity - 1;
+    for (size_t index = to; index != from; index = (index - 1) & mask) {
+        size_t prev = (index - 1) & mask;
+        if (dist[prev] + 1 == kMaxDist) {
+            return false;
+        }
+    }
+    size_t index = to;
+    try {
+        for (; index != from; index = (index - 1) & mask) {
+            size_t prev = (index - 1) & mask;
+            SlotAllocTraits::construct(slot_alloc, slots + index, std::move(slots[prev]));
+            SlotAllocTraits::destroy(slot_alloc, slots + prev);
+            dist[index] = dist[prev] + 1;
+        }
+    } catch (...) {
+        // Moving a pair<const Key, Value> copies the key. Slot `index` is unconstructed and
+        // the elements after it are one slot too far right: move them back. If that throws too,
+        // they are dropped, which still leaves a valid table.
+        size_t gap = index;
+        try {
+            for (; gap != to; gap = (gap + 1) & mask) {
+                size_t next = (gap + 1) & mask;
+                SlotAllocTraits::construct(slot_alloc, slots + gap, std::move(slots[next]));
+                SlotAllocTraits::destroy(slot_alloc, slots + next);
+                dist[gap] = dist[next] - 1;
+            }
+            dist[to] = kEmpty;
+        } catch (...) {
+            dropUnreachable(gap);
+        }
+        throw;
+    }
+    return true;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::prepareInsert(size_t home) {
+    size_t mask = capacity - 1;
+    size_t index = home;
+    uint16_t probe = 1;
+    while (dist[index] >= probe && probe != kMaxDist) {
+        ++probe;
+        index = (index + 1) & mask;
+    }
+    size_t empty = index;
+    while (dist[empty] != kEmpty) {
+        empty = (empty + 1) & mask;
+    }
+    if (probe == kMaxDist || !shiftUp(index, empty)) {
+        return capacity;
+    }
+    dist[index] = probe;
+    ++sz;
+    return index;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+std::pair<size_t, bool> RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::findOrPrepareInsert(const Key& key) {
+    size_t index = findIndex(key);
+    if (index != capacity) {
+        return {index, false};
+    }
+    if (sz + 1 > capacity * _max_load_factor) {
+        resize(capacity == 0 ? kMinCapacity : capacity * 2);
+    }
+    index = prepareInsert(homeIndex(key));
+    if (index == capacity) {
+        // The run is 64K slots long; only a hash that sends that many keys to one bucket gets
+        // here, and doubling the table would not split them.
+        throw std::length_error("RobinHoodUnorderedMap: probe length overflow");
+    }
+    return {index, true};
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<class... Args>
+void RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::constructSlot(size_t index,
+                                                                          Args&&... args) {
+    // prepareInsert() has already claimed the slot; give it back if the element throws.
+    try {
+        SlotAllocTraits::construct(slot_alloc, slots + index, std::forward<Args>(args)...);
+    } catch (...) {
+        releaseIndex(index);
+        throw;
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::eraseIndex(size_t index) {
+    SlotAllocTraits::destroy(slot_alloc, slots + index);
+    return releaseIndex(index);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::releaseIndex(size_t index) {
+    // Shifts the rest of the run back over the (already destroyed) slot and returns the slot
+    // that ends up empty.
+    size_t mask = capacity - 1;
+    size_t next = (index + 1) & mask;
+    --sz;
+    try {
+        while (dist[next] > 1) {
+            SlotAllocTraits::construct(slot_alloc, slots + index, std::move(slots[next]));
+            SlotAllocTraits::destroy(slot_alloc, slots + next);
+            dist[index] = dist[next] - 1;
+            index = next;
+            next = (next + 1) & mask;
+        }
+    } catch (...) {
+        dropUnreachable(index);
+        throw;
+    }
+    dist[index] = kEmpty;
+    return index;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::dropUnreachable(size_t hole) {
+    // Last resort when moving an element within a run throws and cannot be undone: `hole` is
+    // unconstructed and becomes empty, so every later element of the run whose probe sequence
+    // crosses an empty slot can no longer be found and is destroyed. Everything else stays put
+    // and the table stays valid; only those elements are lost.
+    size_t mask = capacity - 1;
+    dist[hole] = kEmpty;
+    size_t last_empty = hole;
+    for (size_t index = (hole + 1) & mask; dist[index] != kEmpty; index = (index + 1) & mask) {
+        if (dist[index] > ((index - last_empty) & mask)) {
+            SlotAllocTraits::destroy(slot_alloc, slots + index);
+            dist[index] = kEmpty;
+            --sz;
+            last_empty = index;
+        }
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::allocateTable(size_t new_capacity) {
+    uint16_t* new_dist = DistAllocTraits::allocate(dist_alloc, new_capacity + 1);
+    try {
+        slots = SlotAllocTraits::allocate(slot_alloc, new_capacity);
+    } catch (...) {
+        DistAllocTraits::deallocate(dist_alloc, new_dist, new_capacity + 1);
+        throw;
+    }
+    dist = new_dist;
+    std::memset(dist, 0, new_capacity * sizeof(uint16_t));
+    dist[new_capacity] = 1;
+    capacity = new_capacity;
+    shift = 64 - std::countr_zero(new_capacity);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::destroySlots() {
+    if constexpr (!std::is_trivially_destructible_v<NodeType>) {
+        for (size_t i = 0; i < capacity; ++i) {
+            if (dist[i] != kEmpty) {
+                SlotAllocTraits::destroy(slot_alloc, slots + i);
+            }
+        }
+    }
+    sz = 0;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::deallocateTable() {
+    if (capacity == 0) {
+        return;
+    }
+    DistAllocTraits::deallocate(dist_alloc, dist, capacity + 1);
+    SlotAllocTraits::deallocate(slot_alloc, slots, capacity);
+    dist = nullptr;
+    slots = nullptr;
+    capacity = 0;
+    shift = 64;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::resize(size_t new_capacity) {
+    uint16_t* old_dist = dist;
+    NodeType* old_slots = slots;
+    size_t old_capacity = capacity;
+    size_t old_shift = shift;
+    size_t old_sz = sz;
+
+    allocateTable(new_capacity);
+    sz = 0;
+    // Moving a pair<const Key, Value> still copies the key, so elements are only moved when that
+    // cannot throw and copied otherwise (std::move_if_noexcept). Either way the old table keeps
+    // its elements until every one has found a slot, so a throwing copy or a probe overflow
+    // drops the new table and leaves the map as it was. As with std::unordered_map, a throwing
+    // hash function gives no such guarantee.
+    try {
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old_dist[i] != kEmpty) {
+                size_t index = prepareInsert(homeIndex(old_slots[i].first));
+                if (index == capacity) {
+                    // Only reachable with a hash that sends 64K keys to one bucket. Moved-from
+                    // pairs still hold a copy of their const key, so the moved elements can be
+                    // looked up and moved back.
+                    if constexpr (std::is_nothrow_move_constructible_v<NodeType>) {
+                        for (size_t j = 0; j < i; ++j) {
+                            if (old_dist[j] != kEmpty) {
+                                NodeType& moved = slots[findIndex(old_slots[j].first)];
+                                SlotAllocTraits::destroy(slot_alloc, old_slots + j);
+                                SlotAllocTraits::construct(slot_alloc, old_slots + j, std::move(moved));
+                            }
+                        }
+                    }
+                    throw std::length_error("RobinHoodUnorderedMap: probe length overflow");
+                }
+                try {
+                    SlotAllocTraits::construct(slot_alloc, slots + index, std::move_if_noexcept(old_slots[i]));
+                } catch (...) {
+                    // The new table is dropped below; only the unconstructed slot must not be
+                    // destroyed with it.
+                    dist[index] = kEmpty;
+                    throw;
+                }
+            }
+        }
+    } catch (...) {
+        destroySlots();
+        deallocateTable();
+        dist = old_dist;
+        slots = old_slots;
+        capacity = old_capacity;
+        shift = old_shift;
+        sz = old_sz;
+        throw;
+    }
+    if constexpr (!std::is_trivially_destructible_v<NodeType>) {
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old_dist[i] != kEmpty) {
+                SlotAllocTraits::destroy(slot_alloc, old_slots + i);
+            }
+        }
+    }
+    if (old_capacity != 0) {
+        DistAllocTraits::deallocate(dist_alloc, old_dist, old_capacity + 1);
+        SlotAllocTraits::deallocate(slot_alloc, old_slots, old_capacity);
+    }
+}
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+Value& RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::operator[](const Key& key) {
+    auto [index, inserted] = findOrPrepareInsert(key);
+    if (inserted) {
+        constructSlot(index, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple());
+    }
+    return slots[index].second;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+Value& RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::operator[](Key&& key) {
+    auto [index, inserted] = findOrPrepareInsert(key);
+    if (inserted) {
+        constructSlot(index, std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple());
+    }
+    return slots[index].second;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+Value& RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::at(const Key& key) {
+    size_t index = findIndex(key);
+    if (index == capacity) {
+        throw std::out_of_range("RobinHoodUnorderedMap::at");
+    }
+    return slots[index].second;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+const Value& RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::at(const Key& key) const {
+    return const_cast<RobinHoodUnorderedMap*>(this)->at(key);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+std::pair<typename RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator, bool>
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::insert(const NodeType& key_val) {
+    auto [index, inserted] = findOrPrepareInsert(key_val.first);
+    if (inserted) {
+        constructSlot(index, key_val);
+    }
+    return {Iterator(dist + index, slots + index), inserted};
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+std::pair<typename RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator, bool>
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::insert(NodeType&& key_val) {
+    auto [index, inserted] = findOrPrepareInsert(key_val.first);
+    if (inserted) {
+        constructSlot(index, std::move(key_val));
+    }
+    return {Iterator(dist + index, slots + index), inserted};
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<class InputIterator>
+void RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::insert(InputIterator begin,
+                                                                   InputIterator end) {
+    for (auto it = begin; it != end; ++it) {
+        insert(*it);
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<class... Args>
+std::pair<typename RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator, bool>
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::emplace(Args&&... args) {
+    return insert(NodeType(std::forward<Args>(args)...));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+typename RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::ConstIterator
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::find(const Key& key) const {
+    return const_cast<RobinHoodUnorderedMap*>(this)->find(key);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+typename RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator
+RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::find(const Key& key) {
+    size_t index = findIndex(key);
+    return Iterator(dist + index, slots + index);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::erase(Iterator iter) {
+    eraseIndex(iter.dist - dist);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::erase(Iterator begin,
+                                                                  Iterator end) {
+    if (begin == end) {
+        return;
+    }
+    if (begin == this->begin() && end == this->end()) {
+        destroySlots();
+        std::memset(dist, 0, capacity * sizeof(uint16_t));
+        return;
+    }
+    // Erase slot by slot. The backward shift pulls the next element of the run into the erased
+    // slot, so the same index is looked at again; if the shift also pulled the slot at `last`
+    // into the range, the range now ends one slot earlier.
+    size_t mask = capacity - 1;
+    size_t index = begin.dist - dist;
+    size_t last = end.dist - dist;
+    while (index != last) {
+        if (dist[index] == kEmpty) {
+            ++index;
+            continue;
+        }
+        size_t shifted = (eraseIndex(index) - index) & mask;
+        if ((((last & mask) - index - 1) & mask) < shifted) {
+            --last;
+        }
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::reserve(size_t new_size) {
+    size_t new_capacity = std::bit_ceil(static_cast<size_t>(new_size / _max_load_factor) + 1);
+    if (new_capacity < kMinCapacity) {
+        new_capacity = kMinCapacity;
+    }
+    if (new_capacity > capacity) {
+        resize(new_capacity);
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::bucket_count() const {
+    return capacity;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::size() const {
+    return sz;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::max_size() const {
+    return SlotAllocTraits::max_size(slot_alloc);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+float RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::load_factor() const {
+    return capacity == 0 ? 0 : static_cast<float>(sz) / capacity;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+float RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::max_load_factor() const {
+    return _max_load_factor;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+void RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::max_load_factor(float ml) {
+    _max_load_factor = ml < 0.95f ? ml : 0.95f;
+    reserve(sz);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc>
+size_t RobinHoodUnorderedMap<Key, Value, Hash, Equal, Alloc>::max_probe_length() const {
+    // Longest number of slots any successful lookup has to inspect; misses stop no later
+    // than one slot past it.
+    uint16_t longest = kEmpty;
+    for (size_t i = 0; i < capacity; ++i) {
+        longest = dist[i] > longest ? dist[i] : longest;
+    }
+    return longest;
+}
@@ -0,0 +1,207 @@
+#include "../flat_unordered_map.h"
+#include "../robin_hood_unordered_map.h"
+
+#include <cassert>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Runs FlatUnorderedMap and RobinHoodUnorderedMap against std::unordered_map through inserts,
+// erases, range erases, copies and moves, then checks that a key whose copy throws leaves
+// either map valid.
+
+// A weak hash, so that probe runs get long and erase has elements to shift.
+struct ClusteringHash {
+    size_t operator()(int key) const {
+        return static_cast<size_t>(key) % 97;
+    }
+};
+
+template<class Map, class Model>
+static void checkSame(const Map& map,
+                      const Model& model) {
+    assert(map.size() == model.size());
+    size_t count = 0;
+    for (const auto& [key, value] : map) {
+        auto it = model.find(key);
+        assert(it != model.end() && it->second == value);
+        ++count;
+    }
+    assert(count == model.size());
+    for (const auto& [key, value] : model) {
+        auto it = map.find(key);
+        assert(it != map.end() && it->second == value);
+    }
+}
+
+template<class Map>
+static void runAgainstStd() {
+    std::mt19937 rng(7);
+    Map map;
+    std::unordered_map<int, std::string> model;
+    for (int step = 0; step < 20000; ++step) {
+        int key = static_cast<int>(rng() % 2000);
+        switch (rng() % 6) {
+            case 0:
+            case 1: {
+                std::string value = std::to_string(step);
+                bool inserted = map.insert({key, value}).second;
+                assert(inserted == model.insert({key, value}).second);
+                break;
+            }
+            case 2:
+                map[key] = std::to_string(-step);
+                model[key] = std::to_string(-step);
+                break;
+            case 3: {
+                auto it = map.find(key);
+                assert((it != map.end()) == model.contains(key));
+                if (it != map.end()) {
+                    map.erase(it);
+                    model.erase(key);
+                }
+                break;
+            }
+            case 4: {
+                // Erase a short run of iterators starting at some element.
+                auto first = map.find(key);
+                if (first == map.end()) {
+                    break;
+                }
+                auto last = first;
+                std::vector<int> erased;
+                for (int i = 0; i < 5 && last != map.end(); ++i, ++last) {
+                    erased.push_back(last->first);
+                }
+                map.erase(first, last);
+                for (int erased_key : erased) {
+                    model.erase(erased_key);
+                }
+                break;
+            }
+            case 5:
+                if (step % 500 == 0) {
+                    map.reserve(map.size() * 2);
+                }
+                break;
+        }
+        if (step % 1000 == 0) {
+            checkSame(map, model);
+        }
+    }
+    checkSame(map, model);
+
+    Map copied(map);
+    checkSame(copied, model);
+    Map assigned;
+    assigned[-1] = "overwritten";
+    assigned = map;
+    checkSame(assigned, model);
+    Map moved(std::move(copied));
+    checkSame(moved, model);
+    assert(copied.size() == 0 && copied.begin() == copied.end());
+    Map move_assigned;
+    move_assigned[-1] = "overwritten";
+    move_assigned = std::move(assigned);
+    checkSame(move_assigned, model);
+
+    map.erase(map.begin(), map.end());
+    assert(map.size() == 0 && map.begin() == map.end());
+    map[1] = "again";
+    assert(map.size() == 1 && map.at(1) == "again");
+}
+
+// Throws from its copy constructor when copies_left runs out. Moving a pair<const Key, Value>
+// copies the key, so this reaches the moves inside resize, insert and erase as well.
+static int copies_left = -1;
+
+struct ThrowingKey {
+    int id;
+
+    ThrowingKey(int id) : id(id) {}
+    ThrowingKey(const ThrowingKey& key) : id(key.id) {
+        if (copies_left >= 0 && copies_left-- == 0) {
+            throw std::runtime_error("ThrowingKey copy");
+        }
+    }
+
+    bool operator==(const ThrowingKey& key) const {
+        return id == key.id;
+    }
+};
+
+struct ThrowingKeyHash {
+    size_t operator()(const ThrowingKey& key) const {
+        return static_cast<size_t>(key.id) % 61;
+    }
+};
+
+// Every element the map holds must be found again and the size must match the elements.
+template<class Map>
+static void checkValid(const Map& map) {
+    size_t count = 0;
+    for (const auto& [key, value] : map) {
+        assert(key.id == value);
+        auto it = map.find(key);
+        assert(it != map.end() && it->second == value);
+        ++count;
+    }
+    assert(count == map.size());
+}
+
+template<class Map>
+static void runThrowingKey() {
+    std::mt19937 rng(11);
+    for (int copy = 0; copy < 40; ++copy) {
+        Map map;
+        for (int i = 0; i < 300; ++i) {
+            map.insert({ThrowingKey(i), i});
+        }
+
+        // A throwing copy during a resize leaves the map as it was.
+        copies_left = copy;
+        try {
+            map.reserve(5000);
+        } catch (const std::runtime_error&) {
+        }
+        copies_left = -1;
+        checkValid(map);
+        assert(map.size() == 300);
+
+        // ...and a throwing copy in a copy constructor leaks nothing.
+        copies_left = copy;
+        try {
+            Map copied(map);
+            checkValid(copied);
+        } catch (const std::runtime_error&) {
+        }
+        copies_left = -1;
+
+        // Inserts and erases whose moves throw keep the map valid.
+        for (int step = 0; step < 300; ++step) {
+            int id = static_cast<int>(rng() % 600);
+            copies_left = static_cast<int>(rng() % 4);
+            try {
+                if (step % 3 != 0) {
+                    map.insert({ThrowingKey(id), id});
+                } else if (auto it = map.find(ThrowingKey(id)); it != map.end()) {
+                    map.erase(it);
+                }
+            } catch (const std::runtime_error&) {
+            }
+            copies_left = -1;
+            checkValid(map);
+        }
+    }
+}
+
+int main() {
+    runAgainstStd<FlatUnorderedMap<int, std::string, ClusteringHash>>();
+    runAgainstStd<RobinHoodUnorderedMap<int, std::string, ClusteringHash>>();
+    runThrowingKey<FlatUnorderedMap<ThrowingKey, int, ThrowingKeyHash>>();
+    runThrowingKey<RobinHoodUnorderedMap<ThrowingKey, int, ThrowingKeyHash>>();
+    return 0;
+}
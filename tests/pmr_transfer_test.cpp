@@ -0,0 +1,46 @@
+#include "../unordered_map.h"
+
+#include <cassert>
+#include <memory_resource>
+#include <string>
+
+// Copying or moving a pmr map into a map on another resource has to rebuild every key and value
+// on the destination's resource, so the source arena can be released afterwards.
+
+using Map = pmr::UnorderedMap<std::pmr::string, std::pmr::string>;
+
+static std::pmr::string longString(const std::string& prefix, int i) {
+    // Long enough to defeat the small-string buffer, so the characters live on the resource.
+    return std::pmr::string(prefix + std::to_string(i) + std::string(32, '.'));
+}
+
+int main() {
+    std::pmr::unsynchronized_pool_resource destination;
+    Map moved(&destination);
+    Map copied(&destination);
+    auto* arena = new std::pmr::monotonic_buffer_resource;
+    {
+        Map source(arena);
+        source.rehash_budget(1); // leave an incremental resize in flight
+        for (int i = 0; i < 500; ++i) {
+            source.emplace(longString("key", i), longString("value", i));
+        }
+        copied = source;
+        moved = std::move(source);
+    }
+    delete arena;
+
+    for (const Map* map : {&moved, &copied}) {
+        assert(map->size() == 500);
+        for (int i = 0; i < 500; ++i) {
+            auto it = map->find(longString("key", i));
+            assert(it != map->end());
+            assert(it->second == longString("value", i));
+            assert(it->first.get_allocator().resource() == &destination);
+            assert(it->second.get_allocator().resource() == &destination);
+        }
+    }
+    moved[longString("key", 500)] = "after";
+    assert(moved.size() == 501);
+    return 0;
+}
@@ -1,12 +1,24 @@
+#include <bit>
+#include <cstdint>
+#include <future>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <list>
 #include <memory>
+#include <memory_resource>
 #include <new>
+#include <ranges>
+#include <span>
 #include <stack>
+#include <stdexcept>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "interleaved.h"
+
 template<typename T, typename Allocator = std::allocator<T>>
 class List {
 private:
@@ -53,10 +65,14 @@ public:
     List(List&& list) noexcept;
     ~List();
     List& operator=(const List& list);
-    List& operator=(List&& list) noexcept;
+    List& operator=(List&& list) noexcept(AllocTraits::propagate_on_container_move_assignment::value ||
+                                          AllocTraits::is_always_equal::value);
+
+    void swap(List& list) noexcept;
 
     auto& get_allocator() const;
     size_t size() const;
+    void clear();
 
     template<typename U>
     void push_back(U&& value);
@@ -78,16 +94,15 @@ public:
     Node* extract(const_iterator pos);
 
 private:
-    Allocator alloc;
-    BaseNodeAlloc base_node_alloc;
-    NodeAlloc node_alloc;
-    TAlloc t_alloc;
+    Allocator alloc; // the node, base-node and element allocators are rebound from it on use
     size_t sz;
-    BaseNode* basic;
+    BaseNode sentinel; // lives in the list object, so creating or moving a list allocates nothing
+    BaseNode* basic = &sentinel;
     void createBasic();
     void moveBasic(List&& list);
     void copyList(const List& list);
     void moveList(List& list) noexcept;
+    void moveElements(List& list);
     void checkPropagateOnContainerCopyAssignment(const List& list);
     void popAllNodes();
     void pop(BaseNode* deleting_node);
@@ -103,11 +118,10 @@ private:
                    U&& value);
 
     BaseNode* push(BaseNode* pos);
-    template<class Key, class Value, class Hash, class Equal, class Alloc>
-    friend class UnorderedMap;
 };
 
 
+// No virtual destructor: nodes are only ever destroyed as Node, never through a BaseNode*.
 template<typename T, typename Allocator>
 struct List<T, Allocator>::BaseNode
 {
@@ -116,7 +130,6 @@ struct List<T, Allocator>::BaseNode
     BaseNode(BaseNode* prev,
              BaseNode* next);
     BaseNode() = default;
-    virtual ~BaseNode() = default;
 };
 
 template<typename T, typename Allocator>
@@ -128,7 +141,6 @@ template<typename T, typename Allocator>
 struct List<T, Allocator>::Node : public List<T, Allocator>::BaseNode
 {
     T value;
-    virtual ~Node() = default;
 };
 
 
@@ -304,15 +316,11 @@ typename List<T, Allocator>::const_reverse_iterator List<T, Allocator>::crend()
 
 template<typename T, typename Allocator>
 void List<T, Allocator>::createBasic() {
-    basic = BaseNodeAllocTraits::allocate(base_node_alloc, 1);
-    BaseNodeAllocTraits::construct(base_node_alloc, basic, basic, basic);
+    basic->prev = basic->next = basic;
 }
 
 template<typename T, typename Allocator>
 List<T, Allocator>::List(const Allocator& alloc) : alloc(alloc),
-                                                   base_node_alloc(alloc),
-                                                   node_alloc(alloc),
-                                                   t_alloc(alloc),
                                                    sz(0) {
     createBasic();
 }
@@ -321,9 +329,6 @@ template<typename T, typename Allocator>
 List<T, Allocator>::List(size_t count,
                          const T& value,
                          const Allocator& alloc) : alloc(alloc),
-                                                   base_node_alloc(alloc),
-                                                   node_alloc(alloc),
-                                                   t_alloc(alloc),
                                                    sz(0) {
     createBasic();
     for (size_t i = 0; i < count; ++i) {
@@ -334,9 +339,6 @@ List<T, Allocator>::List(size_t count,
 template<typename T, typename Allocator>
 List<T, Allocator>::List(size_t count,
                          const Allocator& alloc) : alloc(alloc),
-                                                   base_node_alloc(alloc),
-                                                   node_alloc(alloc),
-                                                   t_alloc(alloc),
                                                    sz(0) {
     createBasic();
     for (size_t i = 0; i < count; ++i) {
@@ -364,28 +366,25 @@ void List<T, Allocator>::copyList(const List& list) {
 
 template<typename T, typename Allocator>
 void List<T, Allocator>::moveList(List& list) noexcept {
+    if (list.sz == 0) {
+        return;
+    }
     basic->prev = list.basic->prev;
     basic->next = list.basic->next;
     list.basic->next->prev = list.basic->prev->next = basic;
-    list.basic->prev = list.basic->next = nullptr;
+    list.basic->prev = list.basic->next = list.basic;
     list.sz = 0;
 }
 
 template<typename T, typename Allocator>
 List<T, Allocator>::List(const List& list) : alloc(AllocTraits::select_on_container_copy_construction(list.alloc)),
-                                             base_node_alloc(BaseNodeAllocTraits::select_on_container_copy_construction(list.base_node_alloc)),
-                                             node_alloc(NodeAllocTraits::select_on_container_copy_construction(list.node_alloc)),
-                                             t_alloc(TAllocTraits::select_on_container_copy_construction(list.t_alloc)),
                                              sz(0) {
     createBasic();
     copyList(list);
 }
 
 template<typename T, typename Allocator>
-List<T, Allocator>::List(List&& list) noexcept : alloc(AllocTraits::select_on_container_copy_construction(list.alloc)),
-                                                 base_node_alloc(BaseNodeAllocTraits::select_on_container_copy_construction(list.base_node_alloc)),
-                                                 node_alloc(NodeAllocTraits::select_on_container_copy_construction(list.node_alloc)),
-                                                 t_alloc(TAllocTraits::select_on_container_copy_construction(list.t_alloc)),
+List<T, Allocator>::List(List&& list) noexcept : alloc(list.alloc),
                                                  sz(list.sz) {
     createBasic();
     moveList(list);
@@ -393,19 +392,29 @@ List<T, Allocator>::List(List&& list) noexcept : alloc(AllocTraits::select_on_co
 
 template<typename T, typename Allocator>
 void List<T, Allocator>::popAllNodes() {
-    size_t old_size = sz;
-    for (size_t i = 0; i < old_size; ++i) {
-        pop_back();
+    // Every node goes, so none of them is unlinked from its neighbours one by one.
+    TAlloc t_alloc(alloc);
+    NodeAlloc node_alloc(alloc);
+    BaseNode* node = basic->next;
+    while (node != basic) {
+        BaseNode* next = node->next;
+        TAllocTraits::destroy(t_alloc, &(reinterpret_cast<Node*>(node)->value));
+        NodeAllocTraits::deallocate(node_alloc, reinterpret_cast<Node*>(node), 1);
+        node = next;
     }
+    createBasic();
+    sz = 0;
+}
+
+template<typename T, typename Allocator>
+void List<T, Allocator>::clear() {
+    popAllNodes();
 }
 
 template<typename T, typename Allocator>
 void List<T, Allocator>::checkPropagateOnContainerCopyAssignment(const List& list) {
-    if (AllocTraits::propagate_on_container_copy_assignment::value && alloc != list.get_allocator()) {
-        alloc = list.get_allocator();
-        base_node_alloc = list.base_node_alloc;
-        node_alloc = list.node_alloc;
-        t_alloc = list.t_alloc;
+    if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+        alloc = list.alloc;
     }
 }
 
@@ -419,20 +428,60 @@ List<T, Allocator>& List<T, Allocator>::operator=(const List& list) {
 }
 
 template<typename T, typename Allocator>
-List<T, Allocator>& List<T, Allocator>::operator=(List&& list) noexcept {
+List<T, Allocator>& List<T, Allocator>::operator=(List&& list)
+        noexcept(AllocTraits::propagate_on_container_move_assignment::value || AllocTraits::is_always_equal::value) {
     if (this == &list) return *this;
     popAllNodes();
-    checkPropagateOnContainerCopyAssignment(list);
+    if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+        alloc = list.alloc;
+    } else if (alloc != list.alloc) {
+        // The nodes belong to a different memory resource and cannot be adopted.
+        moveElements(list);
+        return *this;
+    }
     sz = list.sz;
     moveList(list);
     return *this;
 }
 
+template<typename T, typename Allocator>
+void List<T, Allocator>::moveElements(List& list) {
+    for (BaseNode* list_node = list.basic->next; list_node != list.basic; list_node = list_node->next) {
+        push_back(std::move(reinterpret_cast<Node*>(list_node)->value));
+    }
+    list.popAllNodes();
+}
+
+template<typename T, typename Allocator>
+void List<T, Allocator>::swap(List& list) noexcept {
+    if constexpr (AllocTraits::propagate_on_container_swap::value) {
+        std::swap(alloc, list.alloc);
+    }
+    // The sentinels stay put, so swap what they link to and point the end nodes back at them.
+    std::swap(basic->prev, list.basic->prev);
+    std::swap(basic->next, list.basic->next);
+    std::swap(sz, list.sz);
+    if (sz == 0) {
+        createBasic();
+    } else {
+        basic->next->prev = basic->prev->next = basic;
+    }
+    if (list.sz == 0) {
+        list.createBasic();
+    } else {
+        list.basic->next->prev = list.basic->prev->next = list.basic;
+    }
+}
+
+template<typename T, typename Allocator>
+void swap(List<T, Allocator>& left,
+          List<T, Allocator>& right) noexcept {
+    left.swap(right);
+}
+
 template<typename T, typename Allocator>
 List<T, Allocator>::~List() {
     popAllNodes();
-    BaseNodeAllocTraits::destroy(base_node_alloc, basic);
-    BaseNodeAllocTraits::deallocate(base_node_alloc, basic, 1);
 }
 
 template<typename T, typename Allocator>
@@ -449,8 +498,9 @@ void List<T, Allocator>::pop(BaseNode* deleting_node) {
 
 template<typename T, typename Allocator>
 void List<T, Allocator>::destroyNode(Node* node) {
+    TAlloc t_alloc(alloc);
+    NodeAlloc node_alloc(alloc);
     TAllocTraits::destroy(t_alloc, &(node->value));
-    BaseNodeAllocTraits::destroy(base_node_alloc, node);
     NodeAllocTraits::deallocate(node_alloc, node, 1);
 }
 
@@ -458,6 +508,9 @@ template<typename T, typename Allocator>
 template<typename U>
 typename List<T, Allocator>::BaseNode* List<T, Allocator>::push(BaseNode* pos,
                                                                 U&& value) {
+    NodeAlloc node_alloc(alloc);
+    BaseNodeAlloc base_node_alloc(alloc);
+    TAlloc t_alloc(alloc);
     BaseNode* node = NodeAllocTraits::allocate(node_alloc, 1);
     BaseNodeAllocTraits::construct(base_node_alloc, node, pos->prev, pos);
     TAllocTraits::construct(t_alloc, &(reinterpret_cast<Node*>(node)->value), std::forward<U>(value));
@@ -468,6 +521,9 @@ typename List<T, Allocator>::BaseNode* List<T, Allocator>::push(BaseNode* pos,
 
 template<typename T, typename Allocator>
 typename List<T, Allocator>::BaseNode* List<T, Allocator>::push(BaseNode* pos) {
+    NodeAlloc node_alloc(alloc);
+    BaseNodeAlloc base_node_alloc(alloc);
+    TAlloc t_alloc(alloc);
     BaseNode* node = NodeAllocTraits::allocate(node_alloc, 1);
     BaseNodeAllocTraits::construct(base_node_alloc, node, pos->prev, pos);
     TAllocTraits::construct(t_alloc, &(reinterpret_cast<Node*>(node)->value));
@@ -548,582 +604,2656 @@ typename List<T, Allocator>::Node* List<T, Allocator>::extract(const_iterator po
 
 template<typename T, typename Allocator>
 typename List<T, Allocator>::Node* List<T, Allocator>::createNullNode() {
+    NodeAlloc node_alloc(alloc);
+    BaseNodeAlloc base_node_alloc(alloc);
     Node* node = NodeAllocTraits::allocate(node_alloc, 1);
     BaseNodeAllocTraits::construct(base_node_alloc, reinterpret_cast<BaseNode*>(node), nullptr, nullptr);
     return node;
 }
 
-
-template<class Key, class Value, class Hash = std::hash<Key>, class Equal = std::equal_to<Key>,
-         class Alloc = std::allocator<std::pair<const Key, Value>>>
-class UnorderedMap {
-private:
-    struct Unit;
-
-public:
-    using AllocTraits = std::allocator_traits<Alloc>;
-    using UnitAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Unit>;
-    using UnitAllocTraits = std::allocator_traits<UnitAlloc>;
-    using UnitIterAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<
-            typename List<Unit, UnitAlloc>::iterator>;
-    using UnitIterAllocTraits = std::allocator_traits<UnitIterAlloc>;
-
+// Singly-linked counterpart of List used as UnorderedMap's node storage. The map only walks
+// its nodes forward, so one link per node is enough; before_begin() is an embedded sentinel
+// that lets every bucket be addressed by the node *before* its first element.
+template<typename T, typename Allocator = std::allocator<T>>
+class ForwardList {
 private:
-    static float _max_load_factor;
-    static float _max_size;
-
-    Alloc alloc;
-    List<Unit, UnitAlloc> units;
-    std::vector<typename List<Unit, UnitAlloc>::iterator, UnitIterAlloc> buckets;
-    Hash hasher;
-    Equal comparator;
+    struct BaseNode;
+    struct Node;
 
 public:
-    using NodeType = std::pair<const Key, Value>;
-    UnorderedMap();
-    UnorderedMap(const UnorderedMap& unordered_map);
-    UnorderedMap(UnorderedMap&& unordered_map) noexcept;
-    UnorderedMap& operator=(const UnorderedMap& unordered_map);
-    UnorderedMap& operator=(UnorderedMap&& unordered_map) noexcept;
-    ~UnorderedMap() = default;
-
     template<bool isConst>
     struct common_iterator;
 
-    using Iterator = common_iterator<false>;
-    using ConstIterator = common_iterator<true>;
-
-    Iterator begin();
-    ConstIterator begin() const;
-    Iterator end();
-    ConstIterator end() const;
-    ConstIterator cbegin() const;
-    ConstIterator cend() const;
+    using iterator = common_iterator<false>;
+    using const_iterator = common_iterator<true>;
 
-    size_t bucket_count() const;
-    size_t size() const;
-    size_t max_size() const;
-    float load_factor() const;
-    float max_load_factor() const;
-    void max_load_factor(float ml);
+    iterator before_begin();
+    const_iterator before_begin() const;
+    iterator begin();
+    const_iterator begin() const;
+    iterator end();
+    const_iterator end() const;
+    const_iterator cbefore_begin() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
 
-    Value& operator[](Key&& key);
-    Value& operator[](const Key& key);
+    using AllocTraits = std::allocator_traits<Allocator>;
+    using NodeAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeAllocTraits = std::allocator_traits<NodeAlloc>;
+    using TAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+    using TAllocTraits = std::allocator_traits<TAlloc>;
+    using BaseNodeAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<BaseNode>;
+    using BaseNodeAllocTraits = std::allocator_traits<BaseNodeAlloc>;
 
-    Value& at(const Key& key) const;
+    explicit ForwardList(const Allocator& alloc = Allocator());
+    ForwardList(const ForwardList& list);
+    ForwardList(ForwardList&& list) noexcept;
+    ~ForwardList();
+    ForwardList& operator=(const ForwardList& list);
+    ForwardList& operator=(ForwardList&& list) noexcept(AllocTraits::propagate_on_container_move_assignment::value ||
+                                                        AllocTraits::is_always_equal::value);
 
-    template<typename __NodeType>
-    std::enable_if_t<std::is_constructible_v<NodeType, __NodeType&&>, std::pair<Iterator, bool>>
-    insert(__NodeType&& key_val);
-    std::pair<Iterator, bool> insert(const NodeType& key_val);
-    std::pair<Iterator, bool> insert(NodeType&& key_val);
+    void swap(ForwardList& list) noexcept;
 
-    template<class InputIterator>
-    void insert(InputIterator begin,
-                InputIterator end);
+    auto& get_allocator() const;
+    size_t size() const;
+    void clear();
 
-    template<class... Args>
-    std::pair<Iterator, bool> emplace(Args&&... args);
+    template<typename U>
+    void push_front(U&& value);
 
-    ConstIterator find(const Key& key) const;
-    Iterator find(const Key& key);
+    void pop_front();
 
-    void erase(Iterator iter);
-    void erase(Iterator begin,
-               Iterator end);
+    template<typename U>
+    iterator insert_after(const_iterator pos,
+                          U&& value);
 
-    void reserve(size_t new_size);
+    iterator erase_after(const_iterator pos);
+    iterator erase_after(const_iterator pos,
+                         const_iterator last);
 
 private:
-    void insertNodeInList(typename List<Unit, UnitAlloc>::Node* node,
-                          List<Unit, UnitAlloc>& units,
-                          std::vector<typename List<Unit, UnitAlloc>::iterator,
-                                      UnitIterAlloc>& buckets);
-
-    void rehash_if();
-    decltype(auto) findValueInBucket(size_t hash,
-                                     const Key& key) const;
+    Allocator alloc; // the node, base-node and element allocators are rebound from it on use
+    size_t sz;
+    BaseNode before_head;
+    void copyList(const ForwardList& list);
+    void moveList(ForwardList& list) noexcept;
+    void moveElements(ForwardList& list);
+    void checkPropagateOnContainerCopyAssignment(const ForwardList& list);
+    void popAllNodes();
+    void tieAfter(BaseNode* pos,
+                  BaseNode* new_node);
+    Node* untieAfter(BaseNode* pos);
+    void destroyNode(Node* node);
+    void deallocateNode(Node* node);
 
-    template<typename __NodeType>
-    decltype(auto) insertNewUnitAtBucketBegin(__NodeType&& key_val,
-                                              size_t hash,
-                                              bool insert_to_end);
-    template<typename __Key>
-    Value& generalOperatorSquareBrackets(__Key&& key);
+    template<typename U>
+    Node* createNode(U&& value);
 
-    bool bucketIsEmpty(
-            const std::vector<typename List<Unit, UnitAlloc>::iterator,
-                              UnitIterAlloc>& buckets,
-            size_t hash) const;
+    Node* createNullNode();
 
-    size_t countHash(const Key& key) const;
+    template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+    friend class UnorderedMap;
 };
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-float UnorderedMap<Key, Value, Hash, Equal, Alloc>::_max_load_factor = 0.95;
-
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-float UnorderedMap<Key, Value, Hash, Equal, Alloc>::_max_size = 10000000;
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-struct UnorderedMap<Key, Value, Hash, Equal, Alloc>::Unit
+template<typename T, typename Allocator>
+struct ForwardList<T, Allocator>::BaseNode
 {
-    NodeType key_val;
-    size_t hash;
-
-    template<class __Key, class __Value>
-    Unit(__Key&& key,
-         __Value&& value,
-         size_t hash);
-
-    template<class __NodeType>
-    Unit(__NodeType&& key_val,
-         size_t hash);
+    BaseNode* next;
+    explicit BaseNode(BaseNode* next);
+    BaseNode() = default;
 };
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-template<class __Key, class __Value>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::Unit::Unit(__Key&& key, __Value&& value, size_t hash) : key_val(std::forward<__Key>(key),
-                                                                                                              std::forward<__Value>(value)),
-                                                                                                      hash(hash) {}
+template<typename T, typename Allocator>
+ForwardList<T, Allocator>::BaseNode::BaseNode(BaseNode* next) : next(next) {}
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-template<class __NodeType>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::Unit::Unit(__NodeType&& key_val, size_t hash) : key_val(std::forward<__NodeType>(key_val)),
-                                                                                              hash(hash) {}
+template<typename T, typename Allocator>
+struct ForwardList<T, Allocator>::Node : public ForwardList<T, Allocator>::BaseNode
+{
+    T value;
+};
 
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<typename T, typename Allocator>
 template<bool isConst>
-struct UnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator
+struct ForwardList<T, Allocator>::common_iterator
 {
 private:
-    std::conditional_t<isConst,
-                       typename List<Unit, UnitAlloc>::const_iterator,
-                       typename List<Unit, UnitAlloc>::iterator>
-            list_iter;
+    BaseNode* node;
 
 public:
     using difference_type = std::ptrdiff_t;
-    using value_type = Value;
-    using pointer = std::conditional_t<isConst,
-                                       const Value*,
-                                       Value*>;
-    using reference = std::conditional_t<isConst,
-                                         const Value&,
-                                         Value&>;
+    using value_type = T;
+    using pointer = std::conditional_t<isConst, const T*, T*>;
+    using reference = std::conditional_t<isConst, const T&, T&>;
     using iterator_category = std::forward_iterator_tag;
-
+    common_iterator(const BaseNode* node);
+    common_iterator(BaseNode* node);
     common_iterator() = default;
-    common_iterator(const typename List<Unit, UnitAlloc>::template common_iterator<isConst>& list_iter);
     common_iterator(const common_iterator& iter) = default;
-    common_iterator& operator=(const common_iterator& iter) = default;
-
+    common_iterator& operator=(const common_iterator& common_iter) = default;
+    ~common_iterator() = default;
     decltype(auto) operator++();
     decltype(auto) operator++(int);
-    std::conditional_t<isConst,
-                       const NodeType&,
-                       NodeType&>
-    operator*();
-    std::conditional_t<isConst,
-                       const NodeType*,
-                       NodeType*>
-    operator->();
-    operator ConstIterator();
-
-    friend bool operator==(const common_iterator& first,
-                           const common_iterator& second) {
-        return first.list_iter == second.list_iter;
+    std::conditional_t<isConst, const T&, T&> operator*() const;
+    std::conditional_t<isConst, const T*, T*> operator->() const;
+    operator const_iterator();
+    Node* getNode() const;
+    BaseNode* getBaseNode() const;
+    friend bool operator==(const common_iterator& left,
+                           const common_iterator& right) {
+        return left.node == right.node;
     }
-    friend bool operator!=(const common_iterator& first,
-                           const common_iterator& second) {
-        return !(first == second);
+    friend bool operator!=(const common_iterator& left,
+                           const common_iterator& right) {
+        return left.node != right.node;
     }
-    std::conditional_t<isConst,
-                       const size_t&,
-                       size_t&>
-    hash() const;
-    decltype(auto) listIterator() const;
 };
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<typename T, typename Allocator>
 template<bool isConst>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::
-        common_iterator(const typename List<Unit, UnitAlloc>::template common_iterator<isConst>& list_iter) : list_iter(list_iter) {}
+ForwardList<T, Allocator>::common_iterator<isConst>::
+        common_iterator(const typename ForwardList<T, Allocator>::BaseNode* node) : node(const_cast<BaseNode*>(node)) {}
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<typename T, typename Allocator>
 template<bool isConst>
-decltype(auto) UnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::
-operator++() {
-    ++list_iter;
-    return *this;
+ForwardList<T, Allocator>::common_iterator<isConst>::
+        common_iterator(typename ForwardList<T, Allocator>::BaseNode* node) : node(node) {}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+decltype(auto) ForwardList<T, Allocator>::common_iterator<isConst>::operator++() {
+    node = node->next;
+    return (*this);
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<typename T, typename Allocator>
 template<bool isConst>
-decltype(auto) UnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::
-operator++(int) {
-    auto return_it = *this;
+decltype(auto) ForwardList<T, Allocator>::common_iterator<isConst>::operator++(int) {
+    common_iterator<isConst> return_it = *this;
     ++*this;
     return return_it;
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<typename T, typename Allocator>
 template<bool isConst>
-std::conditional_t<isConst,
-                   const typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::NodeType&,
-                   typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::NodeType&>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::
-operator*() {
-    return list_iter->key_val;
+std::conditional_t<isConst, const T&, T&>
+ForwardList<T, Allocator>::common_iterator<isConst>::operator*() const {
+    return static_cast<Node*>(node)->value;
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<typename T, typename Allocator>
 template<bool isConst>
-std::conditional_t<isConst,
-                   const typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::NodeType*,
-                   typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::NodeType*>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::operator->() {
-    return &list_iter->key_val;
+std::conditional_t<isConst, const T*, T*>
+ForwardList<T, Allocator>::common_iterator<isConst>::operator->() const {
+    return &(static_cast<Node*>(node)->value);
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<typename T, typename Allocator>
 template<bool isConst>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::
-operator ConstIterator() {
-    return ConstIterator(list_iter);
+ForwardList<T, Allocator>::common_iterator<isConst>::operator const_iterator() {
+    return const_iterator(node);
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<typename T, typename Allocator>
 template<bool isConst>
-decltype(auto) UnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::
-        listIterator() const {
-    return list_iter;
+typename ForwardList<T, Allocator>::Node*
+ForwardList<T, Allocator>::common_iterator<isConst>::getNode() const {
+    return static_cast<Node*>(node);
 }
 
-
-template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<typename T, typename Allocator>
 template<bool isConst>
-std::conditional_t<isConst,
-                   const size_t&,
-                   size_t&>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::common_iterator<isConst>::hash() const {
-    return list_iter->hash;
+typename ForwardList<T, Allocator>::BaseNode*
+ForwardList<T, Allocator>::common_iterator<isConst>::getBaseNode() const {
+    return node;
 }
 
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::begin() {
-    return Iterator(units.begin());
+template<typename T, typename Allocator>
+typename ForwardList<T, Allocator>::iterator ForwardList<T, Allocator>::before_begin() {
+    return iterator(&before_head);
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::ConstIterator
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::begin() const {
-    return cbegin();
+template<typename T, typename Allocator>
+typename ForwardList<T, Allocator>::const_iterator ForwardList<T, Allocator>::before_begin() const {
+    return cbefore_begin();
 }
 
+template<typename T, typename Allocator>
+typename ForwardList<T, Allocator>::iterator ForwardList<T, Allocator>::begin() {
+    return iterator(before_head.next);
+}
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::end() {
-    return Iterator(units.end());
+template<typename T, typename Allocator>
+typename ForwardList<T, Allocator>::const_iterator ForwardList<T, Allocator>::begin() const {
+    return cbegin();
+}
+
+template<typename T, typename Allocator>
+typename ForwardList<T, Allocator>::iterator ForwardList<T, Allocator>::end() {
+    return iterator(static_cast<BaseNode*>(nullptr));
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::ConstIterator
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::end() const {
+template<typename T, typename Allocator>
+typename ForwardList<T, Allocator>::const_iterator ForwardList<T, Allocator>::end() const {
     return cend();
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::ConstIterator
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::cbegin() const {
-    return ConstIterator(units.cbegin());
+template<typename T, typename Allocator>
+typename ForwardList<T, Allocator>::const_iterator ForwardList<T, Allocator>::cbefore_begin() const {
+    return const_iterator(&before_head);
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::ConstIterator
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::cend() const {
-    return ConstIterator(units.cend());
+template<typename T, typename Allocator>
+typename ForwardList<T, Allocator>::const_iterator ForwardList<T, Allocator>::cbegin() const {
+    return const_iterator(before_head.next);
 }
 
+template<typename T, typename Allocator>
+typename ForwardList<T, Allocator>::const_iterator ForwardList<T, Allocator>::cend() const {
+    return const_iterator(static_cast<BaseNode*>(nullptr));
+}
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::UnorderedMap() : buckets(2) {}
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::UnorderedMap(const UnorderedMap& unordered_map) : alloc(AllocTraits::select_on_container_copy_construction(unordered_map.alloc)),
-                                                                                                units(unordered_map.units),
-                                                                                                buckets(unordered_map.buckets) {}
+template<typename T, typename Allocator>
+ForwardList<T, Allocator>::ForwardList(const Allocator& alloc) : alloc(alloc),
+                                                                 sz(0),
+                                                                 before_head(nullptr) {}
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::UnorderedMap(UnorderedMap&& unordered_map) noexcept : alloc(AllocTraits::select_on_container_copy_construction(unordered_map.alloc)),
-                                                                                                    units(std::move(unordered_map.units)),
-                                                                                                    buckets(std::move(unordered_map.buckets)) {}
+template<typename T, typename Allocator>
+auto& ForwardList<T, Allocator>::get_allocator() const {
+    return alloc;
+}
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>&
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::operator=(const UnorderedMap& unordered_map) {
-    if (this == &unordered_map) return *this;
-    if (AllocTraits::propagate_on_container_copy_assignment::value && alloc != unordered_map.alloc) {
-        alloc = unordered_map.alloc;
+template<typename T, typename Allocator>
+void ForwardList<T, Allocator>::copyList(const ForwardList& list) {
+    BaseNode* tail = &before_head;
+    for (BaseNode* list_node = list.before_head.next; list_node != nullptr; list_node = list_node->next) {
+        Node* node = createNode(static_cast<Node*>(list_node)->value);
+        tieAfter(tail, node);
+        tail = node;
+    }
+}
+
+template<typename T, typename Allocator>
+void ForwardList<T, Allocator>::moveList(ForwardList& list) noexcept {
+    before_head.next = list.before_head.next;
+    list.before_head.next = nullptr;
+    list.sz = 0;
+}
+
+template<typename T, typename Allocator>
+ForwardList<T, Allocator>::ForwardList(const ForwardList& list) : alloc(AllocTraits::select_on_container_copy_construction(list.alloc)),
+                                                                  sz(0),
+                                                                  before_head(nullptr) {
+    copyList(list);
+}
+
+template<typename T, typename Allocator>
+ForwardList<T, Allocator>::ForwardList(ForwardList&& list) noexcept : alloc(list.alloc),
+                                                                      sz(list.sz),
+                                                                      before_head(nullptr) {
+    moveList(list);
+}
+
+template<typename T, typename Allocator>
+void ForwardList<T, Allocator>::popAllNodes() {
+    BaseNode* node = before_head.next;
+    while (node != nullptr) {
+        BaseNode* next = node->next;
+        destroyNode(static_cast<Node*>(node));
+        node = next;
+    }
+    before_head.next = nullptr;
+    sz = 0;
+}
+
+template<typename T, typename Allocator>
+void ForwardList<T, Allocator>::clear() {
+    popAllNodes();
+}
+
+template<typename T, typename Allocator>
+void ForwardList<T, Allocator>::checkPropagateOnContainerCopyAssignment(const ForwardList& list) {
+    if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+        alloc = list.alloc;
+    }
+}
+
+template<typename T, typename Allocator>
+ForwardList<T, Allocator>& ForwardList<T, Allocator>::operator=(const ForwardList& list) {
+    if (this == &list) return *this;
+    popAllNodes();
+    checkPropagateOnContainerCopyAssignment(list);
+    copyList(list);
+    return *this;
+}
+
+template<typename T, typename Allocator>
+ForwardList<T, Allocator>& ForwardList<T, Allocator>::operator=(ForwardList&& list)
+        noexcept(AllocTraits::propagate_on_container_move_assignment::value || AllocTraits::is_always_equal::value) {
+    if (this == &list) return *this;
+    popAllNodes();
+    if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+        alloc = list.alloc;
+    } else if (alloc != list.alloc) {
+        // The nodes belong to a different memory resource and cannot be adopted.
+        moveElements(list);
+        return *this;
+    }
+    sz = list.sz;
+    moveList(list);
+    return *this;
+}
+
+template<typename T, typename Allocator>
+void ForwardList<T, Allocator>::moveElements(ForwardList& list) {
+    BaseNode* tail = &before_head;
+    for (BaseNode* list_node = list.before_head.next; list_node != nullptr; list_node = list_node->next) {
+        Node* node = createNode(std::move(static_cast<Node*>(list_node)->value));
+        tieAfter(tail, node);
+        tail = node;
+    }
+    list.popAllNodes();
+}
+
+template<typename T, typename Allocator>
+void ForwardList<T, Allocator>::swap(ForwardList& list) noexcept {
+    if constexpr (AllocTraits::propagate_on_container_swap::value) {
+        std::swap(alloc, list.alloc);
+    }
+    std::swap(before_head.next, list.before_head.next);
+    std::swap(sz, list.sz);
+}
+
+template<typename T, typename Allocator>
+void swap(ForwardList<T, Allocator>& left,
+          ForwardList<T, Allocator>& right) noexcept {
+    left.swap(right);
+}
+
+template<typename T, typename Allocator>
+ForwardList<T, Allocator>::~ForwardList() {
+    popAllNodes();
+}
+
+template<typename T, typename Allocator>
+size_t ForwardList<T, Allocator>::size() const {
+    return sz;
+}
+
+template<typename T, typename Allocator>
+void ForwardList<T, Allocator>::tieAfter(BaseNode* pos,
+                                         BaseNode* new_node) {
+    new_node->next = pos->next;
+    pos->next = new_node;
+    ++sz;
+}
+
+template<typename T, typename Allocator>
+typename ForwardList<T, Allocator>::Node* ForwardList<T, Allocator>::untieAfter(BaseNode* pos) {
+    Node* node = static_cast<Node*>(pos->next);
+    pos->next = node->next;
+    --sz;
+    return node;
+}
+
+template<typename T, typename Allocator>
+void ForwardList<T, Allocator>::destroyNode(Node* node) {
+    TAlloc t_alloc(alloc);
+    TAllocTraits::destroy(t_alloc, &(node->value));
+    deallocateNode(node);
+}
+
+template<typename T, typename Allocator>
+void ForwardList<T, Allocator>::deallocateNode(Node* node) {
+    // For a node from createNullNode() whose value was never constructed.
+    NodeAlloc node_alloc(alloc);
+    NodeAllocTraits::deallocate(node_alloc, node, 1);
+}
+
+template<typename T, typename Allocator>
+template<typename U>
+typename ForwardList<T, Allocator>::Node* ForwardList<T, Allocator>::createNode(U&& value) {
+    Node* node = createNullNode();
+    TAlloc t_alloc(alloc);
+    try {
+        TAllocTraits::construct(t_alloc, &(node->value), std::forward<U>(value));
+    } catch (...) {
+        deallocateNode(node);
+        throw;
+    }
+    return node;
+}
+
+template<typename T, typename Allocator>
+typename ForwardList<T, Allocator>::Node* ForwardList<T, Allocator>::createNullNode() {
+    NodeAlloc node_alloc(alloc);
+    BaseNodeAlloc base_node_alloc(alloc);
+    Node* node = NodeAllocTraits::allocate(node_alloc, 1);
+    BaseNodeAllocTraits::construct(base_node_alloc, static_cast<BaseNode*>(node), nullptr);
+    return node;
+}
+
+template<typename T, typename Allocator>
+template<typename U>
+void ForwardList<T, Allocator>::push_front(U&& value) {
+    tieAfter(&before_head, createNode(std::forward<U>(value)));
+}
+
+template<typename T, typename Allocator>
+void ForwardList<T, Allocator>::pop_front() {
+    destroyNode(untieAfter(&before_head));
+}
+
+template<typename T, typename Allocator>
+template<typename U>
+typename ForwardList<T, Allocator>::iterator ForwardList<T, Allocator>::insert_after(const_iterator pos,
+                                                                                   U&& value) {
+    Node* node = createNode(std::forward<U>(value));
+    tieAfter(pos.getBaseNode(), node);
+    return iterator(node);
+}
+
+template<typename T, typename Allocator>
+typename ForwardList<T, Allocator>::iterator ForwardList<T, Allocator>::erase_after(const_iterator pos) {
+    destroyNode(untieAfter(pos.getBaseNode()));
+    return iterator(pos.getBaseNode()->next);
+}
+
+template<typename T, typename Allocator>
+typename ForwardList<T, Allocator>::iterator ForwardList<T, Allocator>::erase_after(const_iterator pos,
+                                                                                  const_iterator last) {
+    BaseNode* before = pos.getBaseNode();
+    while (before->next != last.getBaseNode()) {
+        destroyNode(untieAfter(before));
+    }
+    return iterator(before->next);
+}
+
+
+class BasicGrowthPolicy {
+public:
+    float max_load_factor() const;
+    void max_load_factor(float ml);
+    float min_load_factor() const;
+    void min_load_factor(float ml);
+    float growth_factor() const;
+    void growth_factor(float gf);
+    size_t max_size() const;
+    void max_size(size_t new_max_size);
+
+    bool needsRehash(size_t new_size,
+                     size_t bucket_count) const;
+    size_t grownBucketCount(size_t bucket_count) const;
+    bool needsShrink(size_t new_size,
+                     size_t bucket_count) const;
+
+private:
+    float _max_load_factor = 0.95;
+    float _min_load_factor = 0; // 0 never shrinks automatically
+    float _growth_factor = 2;
+    size_t _max_size = std::numeric_limits<size_t>::max();
+};
+
+inline float BasicGrowthPolicy::max_load_factor() const {
+    return _max_load_factor;
+}
+
+inline void BasicGrowthPolicy::max_load_factor(float ml) {
+    if (_min_load_factor >= ml / _growth_factor) {
+        throw std::invalid_argument("BasicGrowthPolicy::max_load_factor: min_load_factor() must stay below ml / growth_factor()");
+    }
+    _max_load_factor = ml;
+}
+
+inline float BasicGrowthPolicy::min_load_factor() const {
+    return _min_load_factor;
+}
+
+inline void BasicGrowthPolicy::min_load_factor(float ml) {
+    // Right after a growth the load factor is max_load_factor() / growth_factor(), so a threshold
+    // at or above that would shrink the table straight back at the next insert.
+    if (ml < 0 || ml >= _max_load_factor / _growth_factor) {
+        throw std::invalid_argument("BasicGrowthPolicy::min_load_factor: ml must be below max_load_factor() / growth_factor()");
+    }
+    _min_load_factor = ml;
+}
+
+inline float BasicGrowthPolicy::growth_factor() const {
+    return _growth_factor;
+}
+
+inline void BasicGrowthPolicy::growth_factor(float gf) {
+    if (_min_load_factor >= _max_load_factor / gf) {
+        throw std::invalid_argument("BasicGrowthPolicy::growth_factor: min_load_factor() must stay below max_load_factor() / gf");
+    }
+    _growth_factor = gf;
+}
+
+inline size_t BasicGrowthPolicy::max_size() const {
+    return _max_size;
+}
+
+inline void BasicGrowthPolicy::max_size(size_t new_max_size) {
+    _max_size = new_max_size;
+}
+
+inline bool BasicGrowthPolicy::needsRehash(size_t new_size,
+                                           size_t bucket_count) const {
+    return new_size > _max_load_factor * bucket_count;
+}
+
+// Minimum bucket count of the next table: growth_factor() times the current one, but no more
+// than max_size() elements need. The policy's bucketCountFor() rounds it to a valid table size.
+inline size_t BasicGrowthPolicy::grownBucketCount(size_t bucket_count) const {
+    double grown = static_cast<double>(_growth_factor) * bucket_count;
+    double limit = _max_size / static_cast<double>(_max_load_factor) + 1;
+    if (grown > limit) {
+        return bucket_count > limit ? bucket_count : static_cast<size_t>(limit);
+    }
+    return grown > bucket_count ? static_cast<size_t>(grown) : bucket_count + 1;
+}
+
+inline bool BasicGrowthPolicy::needsShrink(size_t new_size,
+                                           size_t bucket_count) const {
+    return new_size < _min_load_factor * bucket_count;
+}
+
+
+class PowerOfTwoGrowthPolicy : public BasicGrowthPolicy {
+public:
+    explicit PowerOfTwoGrowthPolicy(size_t bucket_count = 2);
+
+    size_t bucketIndex(size_t hash) const;
+    size_t bucketCountFor(size_t min_bucket_count) const;
+    void rehashTo(size_t bucket_count);
+
+private:
+    size_t shift;
+};
+
+inline PowerOfTwoGrowthPolicy::PowerOfTwoGrowthPolicy(size_t bucket_count) {
+    rehashTo(bucketCountFor(bucket_count));
+}
+
+inline size_t PowerOfTwoGrowthPolicy::bucketIndex(size_t hash) const {
+    // Fibonacci hashing: multiply by 2^64 / golden ratio and keep the top bits, so identity
+    // hashes like std::hash<int> still spread over every bucket without a division.
+    return static_cast<size_t>((static_cast<uint64_t>(hash) * 11400714819323198485ull) >> shift);
+}
+
+inline size_t PowerOfTwoGrowthPolicy::bucketCountFor(size_t min_bucket_count) const {
+    return min_bucket_count <= 2 ? 2 : std::bit_ceil(min_bucket_count);
+}
+
+inline void PowerOfTwoGrowthPolicy::rehashTo(size_t bucket_count) {
+    shift = 64 - std::countr_zero(bucket_count);
+}
+
+
+class PrimeGrowthPolicy : public BasicGrowthPolicy {
+public:
+    explicit PrimeGrowthPolicy(size_t bucket_count = 2);
+
+    size_t bucketIndex(size_t hash) const;
+    size_t bucketCountFor(size_t min_bucket_count) const;
+    size_t grownBucketCount(size_t bucket_count) const;
+    void rehashTo(size_t bucket_count);
+
+private:
+    static constexpr uint32_t primes[] = {
+            2u, 5u, 11u, 23u, 53u, 97u, 193u, 389u, 769u, 1543u, 3079u, 6151u, 12289u, 24593u,
+            49157u, 98317u, 196613u, 393241u, 786433u, 1572869u, 3145739u, 6291469u, 12582917u,
+            25165843u, 50331653u, 100663319u, 201326611u, 402653189u, 805306457u, 1610612741u,
+            3221225473u, 4294967291u};
+
+    uint32_t divisor;
+    uint64_t reciprocal;
+
+    static uint64_t mulHigh(uint64_t left,
+                            uint32_t right);
+};
+
+inline PrimeGrowthPolicy::PrimeGrowthPolicy(size_t bucket_count) {
+    rehashTo(bucketCountFor(bucket_count));
+}
+
+inline size_t PrimeGrowthPolicy::bucketIndex(size_t hash) const {
+    // Lemire's fastmod: with reciprocal = ceil(2^64 / divisor), the high half of
+    // (reciprocal * n mod 2^64) * divisor is n % divisor for any 32-bit n. The 64-bit hash is
+    // folded to 32 bits first, which keeps every input bit in play.
+    uint32_t folded = static_cast<uint32_t>(hash ^ (static_cast<uint64_t>(hash) >> 32));
+    uint64_t low_bits = reciprocal * folded;
+    return static_cast<size_t>(mulHigh(low_bits, divisor));
+}
+
+// High 64 bits of the 96-bit product left * right.
+inline uint64_t PrimeGrowthPolicy::mulHigh(uint64_t left,
+                                           uint32_t right) {
+#ifdef __SIZEOF_INT128__
+    __extension__ using Wide = unsigned __int128;
+    return static_cast<uint64_t>((static_cast<Wide>(left) * right) >> 64);
+#else
+    // Split left into 32-bit halves; neither partial product nor their sum can overflow.
+    uint64_t high = (left >> 32) * right;
+    uint64_t low = (left & 0xFFFFFFFFu) * right;
+    return (high + (low >> 32)) >> 32;
+#endif
+}
+
+inline size_t PrimeGrowthPolicy::bucketCountFor(size_t min_bucket_count) const {
+    for (uint32_t prime : primes) {
+        if (prime >= min_bucket_count) {
+            return prime;
+        }
+    }
+    throw std::length_error("PrimeGrowthPolicy: bucket count is out of range");
+}
+
+inline size_t PrimeGrowthPolicy::grownBucketCount(size_t bucket_count) const {
+    // The primes are about a factor of two apart, so rounding growth_factor() * bucket_count up
+    // to the next prime would skip a step: take the largest prime that fits instead, and at
+    // least the next one.
+    size_t wanted = BasicGrowthPolicy::grownBucketCount(bucket_count);
+    if (wanted <= bucket_count) {
+        return bucket_count;
+    }
+    size_t grown = bucketCountFor(bucket_count + 1);
+    for (uint32_t prime : primes) {
+        if (prime > wanted) {
+            break;
+        }
+        grown = grown > prime ? grown : prime;
+    }
+    return grown;
+}
+
+inline void PrimeGrowthPolicy::rehashTo(size_t bucket_count) {
+    divisor = static_cast<uint32_t>(bucket_count);
+    reciprocal = UINT64_C(0xFFFFFFFFFFFFFFFF) / divisor + 1;
+}
+
+template<class T, class = void>
+struct IsTransparent : std::false_type {};
+
+template<class T>
+struct IsTransparent<T, std::void_t<typename T::is_transparent>> : std::true_type {};
+
+// Hint that address will be read soon; a no-op on compilers without the builtin.
+inline void prefetchForRead(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address, 0, 3);
+#else
+    (void)address;
+#endif
+}
+
+template<class Key, class Value, class Hash = std::hash<Key>, class Equal = std::equal_to<Key>,
+         class Alloc = std::allocator<std::pair<const Key, Value>>,
+         class GrowthPolicy = PowerOfTwoGrowthPolicy>
+class UnorderedMap {
+private:
+    struct Unit;
+
+public:
+    using AllocTraits = std::allocator_traits<Alloc>;
+    using UnitAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Unit>;
+    using UnitAllocTraits = std::allocator_traits<UnitAlloc>;
+    using UnitList = ForwardList<Unit, UnitAlloc>;
+    using BucketAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<
+            typename UnitList::BaseNode*>;
+    using BucketAllocTraits = std::allocator_traits<BucketAlloc>;
+
+private:
+    // Lookups take any key-like __Key when both Hash and Equal declare is_transparent. The check
+    // is spelled as a variable template so that it depends on __Key and can drive SFINAE.
+    template<typename __Key>
+    static constexpr bool isTransparentKey = IsTransparent<Hash>::value && IsTransparent<Equal>::value;
+    template<typename __Key>
+    using EnableIfTransparent = std::enable_if_t<isTransparentKey<__Key>>;
+
+    UnitList units; // owns the map's allocator, get_allocator() rebinds it back to Alloc
+    // buckets[i] is the node *before* the first node of bucket i (nullptr if the bucket is empty),
+    // so the first node of a bucket can be unlinked without a prev pointer.
+    std::vector<typename UnitList::BaseNode*, BucketAlloc> buckets;
+    Hash hasher;
+    Equal comparator;
+    GrowthPolicy policy;
+
+    // Incremental resize. While old_buckets is non-empty the map is moving from the table described
+    // by old_buckets/old_policy to buckets/policy, one old bucket at a time in index order. A key
+    // lives in the old table iff its old bucket index is >= migrated_buckets, so every lookup knows
+    // which single table to search. The list holds all new-table nodes first, then all old-table
+    // nodes; boundary is the last new-table node (nullptr while the new table is empty).
+    std::vector<typename UnitList::BaseNode*, BucketAlloc> old_buckets;
+    GrowthPolicy old_policy;
+    size_t migrated_buckets = 0;
+    typename UnitList::BaseNode* boundary = nullptr;
+    size_t _rehash_budget = 0;
+
+    // Background resize. Once the load factor passes kBackgroundRehashThreshold of the maximum, the
+    // next bucket array is allocated and a helper thread clears it, so the incremental resize that
+    // follows does O(rehash_budget()) work per insert and nothing proportional to the table size.
+    // The mode always runs with a nonzero rehash budget (kBackgroundRehashBudget unless one is set),
+    // and tables below kBackgroundRehashMinBuckets are cleared inline, where starting a thread
+    // would cost more than the clearing it saves.
+    static constexpr float kBackgroundRehashThreshold = 0.75f;
+    static constexpr size_t kBackgroundRehashBudget = 4;
+    static constexpr size_t kBackgroundRehashMinBuckets = size_t(1) << 16;
+    bool _background_rehash = false;
+    std::future<std::vector<typename UnitList::BaseNode*, BucketAlloc>> prepared_buckets;
+
+public:
+    using NodeType = std::pair<const Key, Value>;
+    UnorderedMap();
+    explicit UnorderedMap(const GrowthPolicy& policy,
+                          const Alloc& alloc = Alloc());
+    explicit UnorderedMap(const Alloc& alloc);
+    template<class InputIterator>
+    UnorderedMap(InputIterator begin,
+                 InputIterator end,
+                 const GrowthPolicy& policy = GrowthPolicy(),
+                 const Alloc& alloc = Alloc());
+    UnorderedMap(const UnorderedMap& unordered_map);
+    UnorderedMap(UnorderedMap&& unordered_map) noexcept;
+    UnorderedMap& operator=(const UnorderedMap& unordered_map);
+    UnorderedMap& operator=(UnorderedMap&& unordered_map) noexcept(AllocTraits::propagate_on_container_move_assignment::value ||
+                                                                   AllocTraits::is_always_equal::value);
+    ~UnorderedMap() = default;
+
+    void swap(UnorderedMap& unordered_map) noexcept;
+    Alloc get_allocator() const;
+    Hash hash_function() const;
+    Equal key_eq() const;
+
+    template<bool isConst>
+    struct common_iterator;
+
+    using Iterator = common_iterator<false>;
+    using ConstIterator = common_iterator<true>;
+
+    Iterator begin();
+    ConstIterator begin() const;
+    Iterator end();
+    ConstIterator end() const;
+    ConstIterator cbegin() const;
+    ConstIterator cend() const;
+
+    size_t bucket_count() const;
+    size_t max_bucket_count() const;
+    size_t bucket(const Key& key) const;
+    template<typename __Key, typename = EnableIfTransparent<__Key>>
+    size_t bucket(const __Key& key) const;
+    size_t bucket_size(size_t bucket) const;
+
+    // A local iterator walks the nodes of buckets [bucket, last_bucket) in bucket index order and
+    // jumps over empty buckets, so the local iterators of a single bucket and the iterators of
+    // bucket_range() are the same type. Each bucket is a contiguous run of the list, so workers
+    // given disjoint bucket ranges never touch each other's nodes. The bucket interface describes
+    // the current table only: while an incremental resize is unfinished (rehash_budget() > 0),
+    // call finish_rehash() before using it.
+    template<bool isConst>
+    struct common_local_iterator;
+
+    using LocalIterator = common_local_iterator<false>;
+    using ConstLocalIterator = common_local_iterator<true>;
+    using BucketRange = std::ranges::subrange<LocalIterator>;
+    using ConstBucketRange = std::ranges::subrange<ConstLocalIterator>;
+
+    LocalIterator begin(size_t bucket);
+    ConstLocalIterator begin(size_t bucket) const;
+    LocalIterator end(size_t bucket);
+    ConstLocalIterator end(size_t bucket) const;
+    ConstLocalIterator cbegin(size_t bucket) const;
+    ConstLocalIterator cend(size_t bucket) const;
+    BucketRange bucket_range(size_t first_bucket,
+                             size_t last_bucket);
+    ConstBucketRange bucket_range(size_t first_bucket,
+                                  size_t last_bucket) const;
+    void finish_rehash();
+
+    size_t size() const;
+    void clear();
+    size_t max_size() const;
+    float load_factor() const;
+    float max_load_factor() const;
+    void max_load_factor(float ml);
+    float min_load_factor() const;
+    void min_load_factor(float ml);
+    GrowthPolicy& growth_policy();
+    const GrowthPolicy& growth_policy() const;
+    size_t rehash_budget() const;
+    void rehash_budget(size_t buckets_per_insert);
+    bool background_rehash() const;
+    void background_rehash(bool enabled);
+
+    Value& operator[](Key&& key);
+    Value& operator[](const Key& key);
+    template<typename __Key, typename = EnableIfTransparent<__Key>>
+    Value& operator[](__Key&& key);
+
+    Value& at(const Key& key) const;
+    template<typename __Key, typename = EnableIfTransparent<__Key>>
+    Value& at(const __Key& key) const;
+
+    template<typename __NodeType>
+    std::enable_if_t<std::is_constructible_v<NodeType, __NodeType&&>, std::pair<Iterator, bool>>
+    insert(__NodeType&& key_val);
+    std::pair<Iterator, bool> insert(const NodeType& key_val);
+    std::pair<Iterator, bool> insert(NodeType&& key_val);
+
+    template<class InputIterator>
+    void insert(InputIterator begin,
+                InputIterator end);
+
+    template<class... Args>
+    std::pair<Iterator, bool> emplace(Args&&... args);
+    // The *_hashed / (key, hash) overloads take hash_function()(key) precomputed by the caller,
+    // e.g. to share one hash between several maps with the same hasher. A wrong hash makes the
+    // key unreachable (or not found) instead of being detected.
+    template<class... Args>
+    std::pair<Iterator, bool> emplace_hashed(size_t hash,
+                                             Args&&... args);
+
+    template<class... Args>
+    std::pair<Iterator, bool> try_emplace(const Key& key,
+                                          Args&&... args);
+    template<class... Args>
+    std::pair<Iterator, bool> try_emplace(Key&& key,
+                                          Args&&... args);
+
+    template<class __Value>
+    std::pair<Iterator, bool> insert_or_assign(const Key& key,
+                                               __Value&& value);
+    template<class __Value>
+    std::pair<Iterator, bool> insert_or_assign(Key&& key,
+                                               __Value&& value);
+
+    ConstIterator find(const Key& key) const;
+    Iterator find(const Key& key);
+    template<typename __Key, typename = EnableIfTransparent<__Key>>
+    ConstIterator find(const __Key& key) const;
+    template<typename __Key, typename = EnableIfTransparent<__Key>>
+    Iterator find(const __Key& key);
+    ConstIterator find(const Key& key,
+                       size_t hash) const;
+    Iterator find(const Key& key,
+                  size_t hash);
+    template<typename __Key, typename = EnableIfTransparent<__Key>>
+    ConstIterator find(const __Key& key,
+                       size_t hash) const;
+    template<typename __Key, typename = EnableIfTransparent<__Key>>
+    Iterator find(const __Key& key,
+                  size_t hash);
+
+    bool contains(const Key& key) const;
+    template<typename __Key, typename = EnableIfTransparent<__Key>>
+    bool contains(const __Key& key) const;
+    bool contains(const Key& key,
+                  size_t hash) const;
+    template<typename __Key, typename = EnableIfTransparent<__Key>>
+    bool contains(const __Key& key,
+                  size_t hash) const;
+
+    // Batched lookups: results[i] is the answer for keys[i]. Keys are processed in groups of
+    // kPrefetchBatch, and each group hashes all its keys before touching the table, prefetching the
+    // bucket slots, then the nodes before each bucket, then the first nodes, before comparing, so
+    // the cache misses of a whole group overlap instead of being taken one after another.
+    void find_many(std::span<const Key> keys,
+                   std::span<Iterator> results);
+    void find_many(std::span<const Key> keys,
+                   std::span<ConstIterator> results) const;
+    void contains_many(std::span<const Key> keys,
+                       std::span<bool> results) const;
+
+    // Coroutine find: yields to scheduler after prefetching the bucket slot, the node before the
+    // bucket and the bucket's first node, so many lookups can be interleaved on one thread. key
+    // is copied into the coroutine frame, since the task starts only when the scheduler runs it;
+    // the map must outlive the task and must not be modified until it has finished.
+    InterleavedTask<Iterator> find_interleaved(Key key,
+                                               InterleavedScheduler& scheduler);
+    size_t count(const Key& key) const;
+    template<typename __Key, typename = EnableIfTransparent<__Key>>
+    size_t count(const __Key& key) const;
+
+    void erase(Iterator iter);
+    void erase(Iterator begin,
+               Iterator end);
+    size_t erase(const Key& key);
+    template<typename __Key, typename = std::enable_if_t<isTransparentKey<__Key> &&
+                                                         !std::is_convertible_v<__Key, Iterator> &&
+                                                         !std::is_convertible_v<__Key, ConstIterator>>>
+    size_t erase(__Key&& key);
+    size_t erase(const Key& key,
+                 size_t hash);
+    template<typename __Key, typename = EnableIfTransparent<__Key>>
+    size_t erase(const __Key& key,
+                 size_t hash);
+
+    void reserve(size_t new_size);
+    void rehash(size_t bucket_count);
+    void shrink_to_fit();
+
+    template<class __Key, class __Value, class __Hash, class __Equal, class __Alloc, class __GrowthPolicy,
+             class Predicate>
+    friend size_t erase_if(UnorderedMap<__Key, __Value, __Hash, __Equal, __Alloc, __GrowthPolicy>& unordered_map,
+                           Predicate pred);
+
+private:
+    void relinkBuckets(size_t new_bucket_count);
+    void eraseNode(Iterator iter);
+    typename UnitList::BaseNode* prevOf(const typename UnitList::BaseNode* node);
+    void eraseRun(typename UnitList::BaseNode* prev,
+                  typename UnitList::BaseNode* last);
+    bool inSameBucket(const typename UnitList::BaseNode* left,
+                      const typename UnitList::BaseNode* right) const;
+    typename UnitList::BaseNode*& headOf(const typename UnitList::BaseNode* node);
+    template<class Predicate>
+    size_t eraseIf(Predicate pred);
+    void shrinkIf();
+    Iterator insertNodeInList(typename UnitList::Node* node);
+
+    void rehash_if();
+    template<typename __UnitList>
+    void appendUnitsOf(__UnitList&& source);
+    void restoreBucketHeads();
+    void relinkFrontBucket();
+
+    bool isMigrating() const;
+    bool inOldTable(size_t hash) const;
+    size_t tableIndex(bool old_table,
+                      size_t hash) const;
+    typename UnitList::BaseNode* oldTableFront();
+    const typename UnitList::BaseNode* newTableEnd() const;
+    void startMigration(size_t new_bucket_count);
+    void migrateBuckets(size_t count);
+    void migrateBucket(size_t old_bucket);
+    void finishMigration();
+    size_t bucketCountForSize(size_t new_size) const;
+    size_t grownBucketCount() const;
+    void prepareBucketsIf();
+    std::vector<typename UnitList::BaseNode*, BucketAlloc> takeBuckets(size_t count);
+    template<typename __Key>
+    decltype(auto) findValueInBucket(size_t hash,
+                                     const __Key& key) const;
+    template<typename __Key>
+    Iterator findKey(const __Key& key) const;
+    template<typename __Key>
+    Iterator findKey(const __Key& key,
+                     size_t hash) const;
+    template<typename __Key>
+    bool containsKey(const __Key& key,
+                     size_t hash) const;
+    std::pair<Iterator, bool> insertUniqueNode(typename UnitList::Node* node,
+                                               size_t hash);
+    template<typename __Key>
+    size_t eraseKey(const __Key& key,
+                    size_t hash);
+    static constexpr size_t kPrefetchBatch = 16;
+    template<class Output>
+    void findBatch(std::span<const Key> keys,
+                   size_t results_size,
+                   Output output) const;
+    typename UnitList::BaseNode* const* bucketSlot(size_t hash) const;
+
+    template<typename... Args>
+    typename UnitList::Node* createUnitNode(Args&&... args);
+    template<typename... Args>
+    decltype(auto) insertNewUnitAtBucketBegin(size_t hash,
+                                              Args&&... args);
+    template<typename __Key, class... Args>
+    std::pair<Iterator, bool> tryEmplace(__Key&& key,
+                                         Args&&... args);
+    template<typename __Key, class... Args>
+    std::pair<Iterator, bool> tryEmplaceHashed(size_t hash,
+                                               __Key&& key,
+                                               Args&&... args);
+    template<typename __Key>
+    Value& generalOperatorSquareBrackets(__Key&& key);
+
+    bool bucketIsEmpty(
+            const std::vector<typename UnitList::BaseNode*,
+                              BucketAlloc>& buckets,
+            size_t bucket) const;
+
+    template<typename __Key>
+    size_t countHash(const __Key& key) const;
+    size_t bucketIndex(size_t hash) const;
+    static size_t hashOf(const typename UnitList::BaseNode* node);
+    size_t bucketOf(const typename UnitList::BaseNode* node) const;
+    const typename UnitList::BaseNode* firstNodeFrom(size_t& bucket,
+                                                     size_t last_bucket) const;
+};
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+struct UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Unit
+{
+    NodeType key_val;
+    size_t hash; // full hasher() result, the bucket is derived from it with bucketIndex()
+
+    template<class __Key, class __Value>
+    Unit(__Key&& key,
+         __Value&& value,
+         size_t hash);
+
+    template<class __NodeType>
+    Unit(__NodeType&& key_val,
+         size_t hash);
+};
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<class __Key, class __Value>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Unit::Unit(__Key&& key, __Value&& value, size_t hash) : key_val(std::forward<__Key>(key),
+                                                                                                                            std::forward<__Value>(value)),
+                                                                                                                    hash(hash) {}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<class __NodeType>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Unit::Unit(__NodeType&& key_val, size_t hash) : key_val(std::forward<__NodeType>(key_val)),
+                                                                                                            hash(hash) {}
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+struct UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_iterator
+{
+private:
+    std::conditional_t<isConst,
+                       typename UnitList::const_iterator,
+                       typename UnitList::iterator>
+            list_iter;
+
+public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = Value;
+    using pointer = std::conditional_t<isConst,
+                                       const Value*,
+                                       Value*>;
+    using reference = std::conditional_t<isConst,
+                                         const Value&,
+                                         Value&>;
+    using iterator_category = std::forward_iterator_tag;
+
+    common_iterator() = default;
+    common_iterator(const typename UnitList::template common_iterator<isConst>& list_iter);
+    common_iterator(const common_iterator& iter) = default;
+    common_iterator& operator=(const common_iterator& iter) = default;
+
+    decltype(auto) operator++();
+    decltype(auto) operator++(int);
+    std::conditional_t<isConst,
+                       const NodeType&,
+                       NodeType&>
+    operator*();
+    std::conditional_t<isConst,
+                       const NodeType*,
+                       NodeType*>
+    operator->();
+    operator ConstIterator();
+
+    friend bool operator==(const common_iterator& first,
+                           const common_iterator& second) {
+        return first.list_iter == second.list_iter;
+    }
+    friend bool operator!=(const common_iterator& first,
+                           const common_iterator& second) {
+        return !(first == second);
+    }
+    std::conditional_t<isConst,
+                       const size_t&,
+                       size_t&>
+    hash() const;
+    decltype(auto) listIterator() const;
+};
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_iterator<isConst>::
+        common_iterator(const typename UnitList::template common_iterator<isConst>& list_iter) : list_iter(list_iter) {}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+decltype(auto) UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_iterator<isConst>::
+operator++() {
+    ++list_iter;
+    return *this;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+decltype(auto) UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_iterator<isConst>::
+operator++(int) {
+    auto return_it = *this;
+    ++*this;
+    return return_it;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+std::conditional_t<isConst,
+                   const typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::NodeType&,
+                   typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::NodeType&>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_iterator<isConst>::
+operator*() {
+    return list_iter->key_val;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+std::conditional_t<isConst,
+                   const typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::NodeType*,
+                   typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::NodeType*>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_iterator<isConst>::operator->() {
+    return &list_iter->key_val;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_iterator<isConst>::
+operator ConstIterator() {
+    return ConstIterator(list_iter);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+decltype(auto) UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_iterator<isConst>::
+        listIterator() const {
+    return list_iter;
+}
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+std::conditional_t<isConst,
+                   const size_t&,
+                   size_t&>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_iterator<isConst>::hash() const {
+    return list_iter->hash;
+}
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+struct UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_local_iterator
+{
+private:
+    const UnorderedMap* map = nullptr;
+    const typename UnitList::BaseNode* node = nullptr; // nullptr once past last_bucket
+    size_t bucket = 0;
+    size_t last_bucket = 0;
+
+    common_local_iterator(const UnorderedMap* map,
+                          const typename UnitList::BaseNode* node,
+                          size_t bucket,
+                          size_t last_bucket);
+
+    friend struct common_local_iterator<!isConst>;
+
+public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = NodeType;
+    using pointer = std::conditional_t<isConst,
+                                       const NodeType*,
+                                       NodeType*>;
+    using reference = std::conditional_t<isConst,
+                                         const NodeType&,
+                                         NodeType&>;
+    using iterator_category = std::forward_iterator_tag;
+
+    common_local_iterator() = default;
+    common_local_iterator(const UnorderedMap* map,
+                          size_t first_bucket,
+                          size_t last_bucket);
+
+    common_local_iterator& operator++();
+    common_local_iterator operator++(int);
+    reference operator*() const;
+    pointer operator->() const;
+    operator ConstLocalIterator() const;
+
+    friend bool operator==(const common_local_iterator& first,
+                           const common_local_iterator& second) {
+        return first.node == second.node;
     }
-    units = unordered_map.units;
-    buckets = unordered_map.buckets;
+    friend bool operator!=(const common_local_iterator& first,
+                           const common_local_iterator& second) {
+        return !(first == second);
+    }
+};
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_local_iterator<isConst>::
+        common_local_iterator(const UnorderedMap* map,
+                              const typename UnitList::BaseNode* node,
+                              size_t bucket,
+                              size_t last_bucket) : map(map),
+                                                    node(node),
+                                                    bucket(bucket),
+                                                    last_bucket(last_bucket) {}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_local_iterator<isConst>::
+        common_local_iterator(const UnorderedMap* map,
+                              size_t first_bucket,
+                              size_t last_bucket) : map(map),
+                                                    bucket(first_bucket),
+                                                    last_bucket(last_bucket) {
+    node = map->firstNodeFrom(bucket, last_bucket);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::template common_local_iterator<isConst>&
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_local_iterator<isConst>::operator++() {
+    node = node->next;
+    if (node == nullptr || map->bucketOf(node) != bucket) {
+        ++bucket;
+        node = map->firstNodeFrom(bucket, last_bucket);
+    }
+    return *this;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::template common_local_iterator<isConst>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_local_iterator<isConst>::operator++(int) {
+    auto return_it = *this;
+    ++*this;
+    return return_it;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::template common_local_iterator<isConst>::reference
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_local_iterator<isConst>::operator*() const {
+    // The map hands out LocalIterator only from its non-const members.
+    return const_cast<typename UnitList::Node*>(static_cast<const typename UnitList::Node*>(node))->value.key_val;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::template common_local_iterator<isConst>::pointer
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_local_iterator<isConst>::operator->() const {
+    return &**this;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<bool isConst>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::common_local_iterator<isConst>::
+operator ConstLocalIterator() const {
+    return ConstLocalIterator(map, node, bucket, last_bucket);
+}
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::begin() {
+    return Iterator(units.begin());
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::ConstIterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::begin() const {
+    return cbegin();
+}
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::end() {
+    return Iterator(units.end());
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::ConstIterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::end() const {
+    return cend();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::ConstIterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::cbegin() const {
+    return ConstIterator(units.cbegin());
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::ConstIterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::cend() const {
+    return ConstIterator(units.cend());
+}
+
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::UnorderedMap() : UnorderedMap(Alloc()) {}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::UnorderedMap(const Alloc& alloc) : UnorderedMap(GrowthPolicy(), alloc) {}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<class InputIterator>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::UnorderedMap(InputIterator begin,
+                                                                       InputIterator end,
+                                                                       const GrowthPolicy& policy,
+                                                                       const Alloc& alloc) : UnorderedMap(policy, alloc) {
+    insert(begin, end);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::UnorderedMap(const GrowthPolicy& policy,
+                                                                       const Alloc& alloc) : units(UnitAlloc(alloc)),
+                                                                                             buckets(policy.bucketCountFor(2), nullptr, BucketAlloc(alloc)),
+                                                                                             policy(policy),
+                                                                                             old_buckets(BucketAlloc(alloc)) {
+    this->policy.rehashTo(buckets.size());
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::UnorderedMap(const UnorderedMap& unordered_map) : units(UnitAllocTraits::select_on_container_copy_construction(unordered_map.units.get_allocator())),
+                                                                                                              buckets(unordered_map.buckets.size(), nullptr, BucketAlloc(units.get_allocator())),
+                                                                                                              hasher(unordered_map.hasher),
+                                                                                                              comparator(unordered_map.comparator),
+                                                                                                              policy(unordered_map.policy),
+                                                                                                              old_buckets(unordered_map.old_buckets.size(), nullptr, BucketAlloc(units.get_allocator())),
+                                                                                                              old_policy(unordered_map.old_policy),
+                                                                                                              migrated_buckets(unordered_map.migrated_buckets),
+                                                                                                              _rehash_budget(unordered_map._rehash_budget),
+                                                                                                              _background_rehash(unordered_map._background_rehash) {
+    appendUnitsOf(unordered_map.units);
+    restoreBucketHeads();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::UnorderedMap(UnorderedMap&& unordered_map) noexcept : units(std::move(unordered_map.units)),
+                                                                                                                  buckets(std::move(unordered_map.buckets)),
+                                                                                                                  hasher(std::move(unordered_map.hasher)),
+                                                                                                                  comparator(std::move(unordered_map.comparator)),
+                                                                                                                  policy(std::move(unordered_map.policy)),
+                                                                                                                  old_buckets(std::move(unordered_map.old_buckets)),
+                                                                                                                  old_policy(std::move(unordered_map.old_policy)),
+                                                                                                                  migrated_buckets(unordered_map.migrated_buckets),
+                                                                                                                  boundary(unordered_map.boundary),
+                                                                                                                  _rehash_budget(unordered_map._rehash_budget),
+                                                                                                                  _background_rehash(unordered_map._background_rehash),
+                                                                                                                  prepared_buckets(std::move(unordered_map.prepared_buckets)) {
+    unordered_map.old_buckets.clear();
+    unordered_map.migrated_buckets = 0;
+    unordered_map.boundary = nullptr;
+    relinkFrontBucket();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>&
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::operator=(const UnorderedMap& unordered_map) {
+    if (this == &unordered_map) return *this;
+    hasher = unordered_map.hasher;
+    comparator = unordered_map.comparator;
+    policy = unordered_map.policy;
+    old_policy = unordered_map.old_policy;
+    migrated_buckets = unordered_map.migrated_buckets;
+    _rehash_budget = unordered_map._rehash_budget;
+    _background_rehash = unordered_map._background_rehash;
+    units.clear();
+    boundary = nullptr;
+    units.checkPropagateOnContainerCopyAssignment(unordered_map.units);
+    buckets.assign(unordered_map.buckets.size(), nullptr);
+    old_buckets.assign(unordered_map.old_buckets.size(), nullptr);
+    appendUnitsOf(unordered_map.units);
+    restoreBucketHeads();
+    return *this;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>&
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::operator=(UnorderedMap&& unordered_map)
+        noexcept(AllocTraits::propagate_on_container_move_assignment::value || AllocTraits::is_always_equal::value) {
+    if (this == &unordered_map) return *this;
+    bool adopts_nodes = AllocTraits::propagate_on_container_move_assignment::value ||
+                        units.get_allocator() == unordered_map.units.get_allocator();
+    hasher = std::move(unordered_map.hasher);
+    comparator = std::move(unordered_map.comparator);
+    policy = std::move(unordered_map.policy);
+    old_policy = std::move(unordered_map.old_policy);
+    migrated_buckets = unordered_map.migrated_buckets;
+    _rehash_budget = unordered_map._rehash_budget;
+    _background_rehash = unordered_map._background_rehash;
+    if (adopts_nodes) {
+        units = std::move(unordered_map.units);
+        buckets = std::move(unordered_map.buckets);
+        // A prepared array belongs to the allocator it was made with, so it follows the buckets.
+        prepared_buckets = std::move(unordered_map.prepared_buckets);
+        old_buckets = std::move(unordered_map.old_buckets);
+        boundary = unordered_map.boundary;
+        relinkFrontBucket();
+    } else {
+        // The nodes belong to another allocator, so the elements are moved one by one into our
+        // own memory, in the same order.
+        units.clear();
+        boundary = nullptr;
+        buckets.assign(unordered_map.buckets.size(), nullptr);
+        old_buckets.assign(unordered_map.old_buckets.size(), nullptr);
+        appendUnitsOf(std::move(unordered_map.units));
+        unordered_map.units.clear();
+        unordered_map.buckets.assign(unordered_map.buckets.size(), nullptr);
+        restoreBucketHeads();
+    }
+    unordered_map.old_buckets.clear();
+    unordered_map.migrated_buckets = 0;
+    unordered_map.boundary = nullptr;
     return *this;
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>&
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::operator=(UnorderedMap&& unordered_map) noexcept {
-    if (this == &unordered_map) return *this;
-    if (AllocTraits::propagate_on_container_copy_assignment::value && alloc != unordered_map.alloc) {
-        alloc = unordered_map.alloc;
-    }
-    units = std::move(unordered_map.units);
-    buckets = std::move(unordered_map.buckets);
-    return *this;
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::swap(UnorderedMap& unordered_map) noexcept {
+    using std::swap;
+    units.swap(unordered_map.units);
+    buckets.swap(unordered_map.buckets);
+    swap(hasher, unordered_map.hasher);
+    swap(comparator, unordered_map.comparator);
+    swap(policy, unordered_map.policy);
+    old_buckets.swap(unordered_map.old_buckets);
+    swap(old_policy, unordered_map.old_policy);
+    swap(migrated_buckets, unordered_map.migrated_buckets);
+    swap(boundary, unordered_map.boundary);
+    swap(_rehash_budget, unordered_map._rehash_budget);
+    swap(_background_rehash, unordered_map._background_rehash);
+    swap(prepared_buckets, unordered_map.prepared_buckets);
+    relinkFrontBucket();
+    unordered_map.relinkFrontBucket();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void swap(UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>& left,
+          UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>& right) noexcept {
+    left.swap(right);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+Alloc UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::get_allocator() const {
+    return Alloc(units.get_allocator());
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+Hash UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::hash_function() const {
+    return hasher;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+Equal UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::key_eq() const {
+    return comparator;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<class __Key>
+Value& UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::generalOperatorSquareBrackets(__Key&& key) {
+    // The key and a value-initialized Value are built straight in the node, so Value needs
+    // neither a move nor a copy constructor.
+    return tryEmplace(std::forward<__Key>(key)).first->second;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+Value& UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::operator[](const Key& key) {
+    return generalOperatorSquareBrackets(key);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+Value& UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::operator[](Key&& key) {
+    return generalOperatorSquareBrackets(std::move(key));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key, typename>
+Value& UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::operator[](__Key&& key) {
+    // A Key is only built from key when the lookup misses.
+    return generalOperatorSquareBrackets(std::forward<__Key>(key));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+Value& UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::at(const Key& key) const {
+    Iterator it = findKey(key);
+    if (it != Iterator(const_cast<UnitList&>(units).end())) {
+        return it->second;
+    }
+    throw std::exception();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key, typename>
+Value& UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::at(const __Key& key) const {
+    Iterator it = findKey(key);
+    if (it != Iterator(const_cast<UnitList&>(units).end())) {
+        return it->second;
+    }
+    throw std::exception();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key>
+decltype(auto)
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::findValueInBucket(size_t hash,
+                                                                              const __Key& key) const {
+    if (buckets.empty()) {
+        // Only a moved-from map has no buckets; the insert that follows a miss grows it.
+        return std::pair<Iterator, bool>{Iterator(const_cast<UnitList&>(units).end()), true};
+    }
+    bool old_table = inOldTable(hash);
+    auto& table = old_table ? old_buckets : buckets;
+    size_t bucket = tableIndex(old_table, hash);
+    auto end = Iterator(const_cast<UnitList&>(units).end());
+    if (bucketIsEmpty(table, bucket)) {
+        return std::pair<Iterator, bool>{end, true};
+    }
+    auto it = Iterator(table[bucket]->next);
+    auto table_end = old_table ? end : Iterator(typename UnitList::iterator(newTableEnd()));
+    while (it != table_end && tableIndex(old_table, it.hash()) == bucket) {
+        if (it.hash() == hash && comparator(it->first, key)) {
+            return std::pair<Iterator, bool>{it, false};
+        }
+        ++it;
+    }
+    return std::pair<Iterator, bool>{it, true};
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename... Args>
+decltype(auto)
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::insertNewUnitAtBucketBegin(size_t hash,
+                                                                                       Args&&... args) {
+    typename UnitList::Node* node = createUnitNode(std::forward<Args>(args)...);
+    node->value.hash = hash;
+    return std::pair<Iterator, bool>(insertNodeInList(node), true);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename... Args>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::UnitList::Node*
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::createUnitNode(Args&&... args) {
+    // Allocates a node and builds its key_val through Alloc, so that uses-allocator construction
+    // reaches the key and value; the hash is left to the caller. The node is freed if the
+    // element throws.
+    typename UnitList::Node* node = units.createNullNode();
+    Alloc alloc = get_allocator();
+    try {
+        AllocTraits::construct(alloc, &(node->value.key_val), std::forward<Args>(args)...);
+    } catch (...) {
+        units.deallocateNode(node);
+        throw;
+    }
+    return node;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __NodeType>
+std::enable_if_t<std::is_constructible_v<
+                         typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::NodeType, __NodeType&&>,
+                 std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator, bool>>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::insert(__NodeType&& key_val) {
+    return emplace(std::forward<__NodeType>(key_val));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator, bool>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::insert(const NodeType& key_val) {
+    return emplace(key_val);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator, bool>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::insert(NodeType&& key_val) {
+    return emplace(std::move(key_val));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::findKey(const __Key& key) const {
+    return findKey(key, countHash(key));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::findKey(const __Key& key,
+                                                                    size_t hash) const {
+    std::pair<Iterator, bool> value_was_found_in_bucket = findValueInBucket(hash, key);
+    if (!value_was_found_in_bucket.second) {
+        return value_was_found_in_bucket.first;
+    }
+    return Iterator(const_cast<UnitList&>(units).end());
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key>
+bool UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::containsKey(const __Key& key,
+                                                                        size_t hash) const {
+    // Same walk as findValueInBucket(), but on raw node pointers and without building iterators.
+    // A node with the probed hash is in the probed bucket too, so the bucket index is only
+    // recomputed for nodes whose hash differs.
+    if (buckets.empty()) {
+        return false;
+    }
+    bool old_table = inOldTable(hash);
+    size_t bucket = tableIndex(old_table, hash);
+    const typename UnitList::BaseNode* prev = (old_table ? old_buckets : buckets)[bucket];
+    if (prev == nullptr) {
+        return false;
+    }
+    const typename UnitList::BaseNode* table_end = old_table ? nullptr : newTableEnd();
+    for (const typename UnitList::BaseNode* node = prev->next; node != table_end; node = node->next) {
+        const Unit& unit = static_cast<const typename UnitList::Node*>(node)->value;
+        if (unit.hash == hash) {
+            if (comparator(unit.key_val.first, key)) {
+                return true;
+            }
+        } else if (tableIndex(old_table, unit.hash) != bucket) {
+            return false;
+        }
+    }
+    return false;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::ConstIterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::find(const Key& key) const {
+    return findKey(key);
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-template<class __Key>
-Value& UnorderedMap<Key, Value, Hash, Equal, Alloc>::generalOperatorSquareBrackets(__Key&& key) {
-    rehash_if();
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::find(const Key& key) {
+    return findKey(key);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key, typename>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::ConstIterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::find(const __Key& key) const {
+    return findKey(key);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key, typename>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::find(const __Key& key) {
+    return findKey(key);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::ConstIterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::find(const Key& key,
+                                                                 size_t hash) const {
+    return findKey(key, hash);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::find(const Key& key,
+                                                                 size_t hash) {
+    return findKey(key, hash);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key, typename>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::ConstIterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::find(const __Key& key,
+                                                                 size_t hash) const {
+    return findKey(key, hash);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key, typename>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::find(const __Key& key,
+                                                                 size_t hash) {
+    return findKey(key, hash);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+bool UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::contains(const Key& key) const {
+    return containsKey(key, countHash(key));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key, typename>
+bool UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::contains(const __Key& key) const {
+    return containsKey(key, countHash(key));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+bool UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::contains(const Key& key,
+                                                                     size_t hash) const {
+    return containsKey(key, hash);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key, typename>
+bool UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::contains(const __Key& key,
+                                                                     size_t hash) const {
+    return containsKey(key, hash);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::find_many(std::span<const Key> keys,
+                                                                      std::span<Iterator> results) {
+    findBatch(keys, results.size(), [&results](size_t i, Iterator it) { results[i] = it; });
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::find_many(std::span<const Key> keys,
+                                                                      std::span<ConstIterator> results) const {
+    findBatch(keys, results.size(), [&results](size_t i, Iterator it) { results[i] = it; });
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::contains_many(std::span<const Key> keys,
+                                                                          std::span<bool> results) const {
+    Iterator end_it(const_cast<UnitList&>(units).end());
+    findBatch(keys, results.size(), [&results, end_it](size_t i, Iterator it) { results[i] = it != end_it; });
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+InterleavedTask<typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::find_interleaved(Key key,
+                                                                             InterleavedScheduler& scheduler) {
     size_t hash = countHash(key);
-    if (bucketIsEmpty(buckets, hash)) {
-        return insertNewUnitAtBucketBegin(NodeType(std::forward<Key>(key), Value()), hash, true).first->second;
+    prefetchForRead(bucketSlot(hash));
+    co_await scheduler.yield();
+    if (const typename UnitList::BaseNode* head = *bucketSlot(hash)) {
+        prefetchForRead(head);
+        co_await scheduler.yield();
+        prefetchForRead(head->next);
+        co_await scheduler.yield();
     }
-    std::pair<Iterator, bool> value_was_found_in_bucket = findValueInBucket(hash, key);
-    if (!value_was_found_in_bucket.second) {
-        return value_was_found_in_bucket.first->second;
+    co_return findKey(key, hash);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<class Output>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::findBatch(std::span<const Key> keys,
+                                                                      size_t results_size,
+                                                                      Output output) const {
+    if (results_size < keys.size()) {
+        throw std::length_error("UnorderedMap::find_many: fewer results than keys");
+    }
+    size_t hashes[kPrefetchBatch];
+    for (size_t first = 0; first < keys.size(); first += kPrefetchBatch) {
+        size_t count = keys.size() - first < kPrefetchBatch ? keys.size() - first : kPrefetchBatch;
+        for (size_t i = 0; i < count; ++i) {
+            hashes[i] = countHash(keys[first + i]);
+            prefetchForRead(bucketSlot(hashes[i]));
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (const typename UnitList::BaseNode* head = *bucketSlot(hashes[i])) {
+                prefetchForRead(head);
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (const typename UnitList::BaseNode* head = *bucketSlot(hashes[i])) {
+                prefetchForRead(head->next);
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            output(first + i, findKey(keys[first + i], hashes[i]));
+        }
     }
-    return insertNewUnitAtBucketBegin(NodeType(std::forward<__Key>(key), Value()), hash, false).first->second;
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-Value& UnorderedMap<Key, Value, Hash, Equal, Alloc>::operator[](const Key& key) {
-    return generalOperatorSquareBrackets(key);
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::UnitList::BaseNode* const*
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::bucketSlot(size_t hash) const {
+    static typename UnitList::BaseNode* const no_bucket = nullptr;
+    if (buckets.empty()) {
+        return &no_bucket;
+    }
+    bool old_table = inOldTable(hash);
+    return &(old_table ? old_buckets : buckets)[tableIndex(old_table, hash)];
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-Value& UnorderedMap<Key, Value, Hash, Equal, Alloc>::operator[](Key&& key) {
-    return generalOperatorSquareBrackets(std::move(key));
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::count(const Key& key) const {
+    return containsKey(key, countHash(key)) ? 1 : 0;
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-Value& UnorderedMap<Key, Value, Hash, Equal, Alloc>::at(const Key& key) const {
-    size_t hash = countHash(key);
-    if (bucketIsEmpty(buckets, hash)) {
-        throw std::exception();
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key, typename>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::count(const __Key& key) const {
+    return containsKey(key, countHash(key)) ? 1 : 0;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<class InputIterator>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::insert(InputIterator begin,
+                                                                        InputIterator end) {
+    using Category = typename std::iterator_traits<InputIterator>::iterator_category;
+    using Element = std::remove_cvref_t<typename std::iterator_traits<InputIterator>::reference>;
+    if constexpr (!std::is_base_of_v<std::forward_iterator_tag, Category>) {
+        for (auto it = begin; it != end; ++it) {
+            insert(*it);
+        }
+    } else {
+        // Grow once for the whole range; duplicates only make this an overestimate.
+        reserve(size() + static_cast<size_t>(std::distance(begin, end)));
+        if constexpr (!std::is_same_v<Element, NodeType> && !std::is_same_v<Element, std::pair<Key, Value>>) {
+            for (auto it = begin; it != end; ++it) {
+                insert(*it);
+            }
+        } else {
+            // Hash a group of keys and prefetch their bucket slots before linking any of them, as
+            // find_many() does; duplicates are found before a node is allocated.
+            size_t hashes[kPrefetchBatch];
+            while (begin != end) {
+                InputIterator first = begin;
+                size_t count = 0;
+                for (; count < kPrefetchBatch && begin != end; ++count, ++begin) {
+                    hashes[count] = countHash((*begin).first);
+                    prefetchForRead(bucketSlot(hashes[count]));
+                }
+                for (size_t i = 0; i < count; ++i, ++first) {
+                    auto&& element = *first;
+                    tryEmplaceHashed(hashes[i],
+                                     std::forward<decltype(element)>(element).first,
+                                     std::forward<decltype(element)>(element).second);
+                }
+            }
+        }
     }
-    std::pair<Iterator, bool> value_was_found_in_bucket = findValueInBucket(hash, key);
-    if (!value_was_found_in_bucket.second) {
-        return value_was_found_in_bucket.first->second;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::rehash_if() {
+    if (isMigrating()) {
+        migrateBuckets(_rehash_budget);
+    }
+    shrinkIf();
+    prepareBucketsIf();
+    if (policy.needsRehash(size() + 1, bucket_count())) {
+        if (_rehash_budget != 0) {
+            startMigration(grownBucketCount());
+            return;
+        }
+        if (isMigrating()) {
+            finishMigration();
+        }
+        size_t new_bucket_count = grownBucketCount();
+        if (new_bucket_count != bucket_count()) {
+            relinkBuckets(new_bucket_count);
+        }
     }
-    throw std::exception();
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-decltype(auto)
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::findValueInBucket(size_t hash,
-                                                                const Key& key) const {
-    auto it = Iterator(buckets[hash]);
-    while (it.hash() == hash) {
-        if (comparator(it->first, key)) {
-            return std::pair<Iterator, bool>{it, false};
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __UnitList>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::appendUnitsOf(__UnitList&& source) {
+    // Copies (or, for an rvalue source, moves) source's elements into the empty units, keeping
+    // their order and hashes. key_val is built by createUnitNode(): Unit is not allocator-aware,
+    // so constructing it through the list would copy a pmr key or value with its old resource
+    // instead of ours. On exception units is left empty.
+    typename UnitList::BaseNode* tail = &units.before_head;
+    try {
+        for (auto& unit : source) {
+            typename UnitList::Node* node;
+            if constexpr (std::is_lvalue_reference_v<__UnitList>) {
+                node = createUnitNode(unit.key_val);
+            } else {
+                node = createUnitNode(std::move(unit.key_val));
+            }
+            node->value.hash = unit.hash;
+            units.tieAfter(tail, node);
+            tail = node;
         }
-        ++it;
+    } catch (...) {
+        units.clear();
+        throw;
     }
-    return std::pair<Iterator, bool>{it, true};
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-template<typename __NodeType>
-decltype(auto)
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::insertNewUnitAtBucketBegin(__NodeType&& key_val,
-                                                                         size_t hash,
-                                                                         bool insert_to_end) {
-    buckets[hash] = units.insert((insert_to_end ? units.end() : buckets[hash]),
-                                 Unit(std::forward<__NodeType>(key_val), hash));
-    return std::pair<Iterator, bool>(Iterator(buckets[hash]), true);
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::restoreBucketHeads() {
+    // A copied list keeps the bucket runs in order, so the node before the first one seen for a
+    // bucket is its head.
+    // During a resize the new-table nodes come first, so boundary ends up on the last of them.
+    boundary = nullptr;
+    typename UnitList::BaseNode* prev = &units.before_head;
+    for (typename UnitList::BaseNode* node = prev->next; node != nullptr; prev = node, node = node->next) {
+        size_t hash = hashOf(node);
+        bool old_table = inOldTable(hash);
+        auto& table = old_table ? old_buckets : buckets;
+        size_t bucket = tableIndex(old_table, hash);
+        if (bucketIsEmpty(table, bucket)) {
+            table[bucket] = prev;
+        }
+        if (!old_table && isMigrating()) {
+            boundary = node;
+        }
+    }
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-template<typename __NodeType>
-std::enable_if_t<std::is_constructible_v<
-                         typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::NodeType, __NodeType&&>,
-                 std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator, bool>>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::insert(__NodeType&& key_val) {
-    return emplace(std::forward<__NodeType>(key_val));
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::relinkFrontBucket() {
+    // The bucket at the front of the list points at before_head, which does not move with the nodes.
+    if (units.before_head.next != nullptr) {
+        size_t hash = hashOf(units.before_head.next);
+        bool old_table = inOldTable(hash);
+        (old_table ? old_buckets : buckets)[tableIndex(old_table, hash)] = &units.before_head;
+    }
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator, bool>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::insert(const NodeType& key_val) {
-    return emplace(key_val);
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+bool UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::isMigrating() const {
+    return !old_buckets.empty();
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator, bool>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::insert(NodeType&& key_val) {
-    return emplace(std::move(key_val));
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+bool UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::inOldTable(size_t hash) const {
+    return isMigrating() && old_policy.bucketIndex(hash) >= migrated_buckets;
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::ConstIterator
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::find(const Key& key) const {
-    size_t hash = countHash(key);
-    if (bucketIsEmpty(buckets, hash)) {
-        return end();
-    }
-    std::pair<Iterator, bool> value_was_found_in_bucket = findValueInBucket(hash, key);
-    if (!value_was_found_in_bucket.second) {
-        return value_was_found_in_bucket.first;
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::tableIndex(bool old_table,
+                                                                              size_t hash) const {
+    return old_table ? old_policy.bucketIndex(hash) : bucketIndex(hash);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::UnitList::BaseNode*
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::oldTableFront() {
+    return boundary != nullptr ? boundary : &units.before_head;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+const typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::UnitList::BaseNode*
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::newTableEnd() const {
+    if (!isMigrating()) {
+        return nullptr;
     }
-    return end();
+    return boundary != nullptr ? boundary->next : units.before_head.next;
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::find(const Key& key) {
-    size_t hash = countHash(key);
-    if (bucketIsEmpty(buckets, hash)) {
-        return end();
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::startMigration(size_t new_bucket_count) {
+    if (isMigrating()) {
+        finishMigration();
     }
-    std::pair<Iterator, bool> value_was_found_in_bucket = findValueInBucket(hash, key);
-    if (!value_was_found_in_bucket.second) {
-        return value_was_found_in_bucket.first;
+    if (new_bucket_count == bucket_count()) {
+        return;
+    }
+    // Every node now belongs to the old table, which starts right after before_head.
+    old_buckets.swap(buckets);
+    buckets = takeBuckets(new_bucket_count);
+    old_policy = policy;
+    policy.rehashTo(new_bucket_count);
+    migrated_buckets = 0;
+    boundary = nullptr;
+    migrateBuckets(_rehash_budget);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::migrateBuckets(size_t count) {
+    for (; count > 0 && migrated_buckets < old_buckets.size(); --count) {
+        migrateBucket(migrated_buckets);
+    }
+    if (migrated_buckets == old_buckets.size()) {
+        old_buckets.clear();
+        old_buckets.shrink_to_fit();
+        migrated_buckets = 0;
+        boundary = nullptr;
     }
-    return end();
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-template<class InputIterator>
-void UnorderedMap<Key, Value, Hash, Equal, Alloc>::insert(InputIterator begin,
-                                                          InputIterator end) {
-    for (auto it = begin; it != end; ++it) {
-        insert(*it);
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::migrateBucket(size_t old_bucket) {
+    // Advance the cursor first so that the unlinked nodes route to the new table.
+    migrated_buckets = old_bucket + 1;
+    typename UnitList::BaseNode* prev = old_buckets[old_bucket];
+    if (prev == nullptr) {
+        return;
+    }
+    old_buckets[old_bucket] = nullptr;
+    typename UnitList::BaseNode* run = nullptr;
+    while (prev->next != nullptr && old_policy.bucketIndex(hashOf(prev->next)) == old_bucket) {
+        typename UnitList::Node* node = units.untieAfter(prev);
+        node->next = run;
+        run = node;
+    }
+    if (prev->next != nullptr) {
+        old_buckets[old_policy.bucketIndex(hashOf(prev->next))] = prev;
     }
+    while (run != nullptr) {
+        typename UnitList::Node* node = static_cast<typename UnitList::Node*>(run);
+        run = run->next;
+        insertNodeInList(node);
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::finishMigration() {
+    migrateBuckets(old_buckets.size());
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::bucketCountForSize(size_t new_size) const {
+    return policy.bucketCountFor(new_size / max_load_factor() + 1);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::grownBucketCount() const {
+    return policy.bucketCountFor(policy.grownBucketCount(bucket_count()));
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-void UnorderedMap<Key, Value, Hash, Equal, Alloc>::rehash_if() {
-    if (size() + 1 > max_load_factor() * bucket_count()) {
-        reserve(2 * bucket_count() * max_load_factor() + 1);
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::prepareBucketsIf() {
+    if (!_background_rehash || prepared_buckets.valid() || isMigrating() ||
+        load_factor() < max_load_factor() * kBackgroundRehashThreshold) {
+        return;
     }
+    size_t count = grownBucketCount();
+    if (count == bucket_count() || count < kBackgroundRehashMinBuckets) {
+        return;
+    }
+    // The array is allocated here, on the inserting thread, and the helper only clears it: assign()
+    // stays within the reserved capacity, so the allocator is never called from two threads.
+    std::vector<typename UnitList::BaseNode*, BucketAlloc> prepared(buckets.get_allocator());
+    prepared.reserve(count);
+    prepared_buckets = std::async(std::launch::async, [prepared = std::move(prepared), count]() mutable {
+        prepared.assign(count, nullptr);
+        return std::move(prepared);
+    });
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+std::vector<typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::UnitList::BaseNode*, typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::BucketAlloc>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::takeBuckets(size_t count) {
+    if (prepared_buckets.valid()) {
+        // Waits only if the helper is still clearing the array; a stale size is simply dropped.
+        std::vector<typename UnitList::BaseNode*, BucketAlloc> prepared = prepared_buckets.get();
+        if (prepared.size() == count) {
+            return prepared;
+        }
+    }
+    return std::vector<typename UnitList::BaseNode*, BucketAlloc>(count, nullptr, buckets.get_allocator());
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-void UnorderedMap<Key, Value, Hash, Equal, Alloc>::reserve(size_t new_size) {
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::reserve(size_t new_size) {
+    if (new_size > max_size()) {
+        throw std::length_error("UnorderedMap::reserve: new_size exceeds max_size()");
+    }
+    if (isMigrating()) {
+        finishMigration();
+    }
     if (new_size / max_load_factor() + 1 < size()) {
         return;
     }
-    std::vector<typename List<Unit, UnitAlloc>::iterator, UnitIterAlloc>
-            new_buckets(new_size / max_load_factor() + 1);
-    List<Unit, UnitAlloc> new_units;
-    typename List<Unit, UnitAlloc>::iterator iter = units.begin();
-    while (iter != units.end()) {
-        typename List<Unit, UnitAlloc>::iterator copy_iter = iter++;
-        typename List<Unit, UnitAlloc>::Node* node = units.extract(copy_iter);
-        insertNodeInList(node, new_units, new_buckets);
-    }
-    buckets = std::move(new_buckets);
-    units = std::move(new_units);
-}
-
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-void UnorderedMap<Key, Value, Hash, Equal, Alloc>::
-        insertNodeInList(typename List<Unit, UnitAlloc>::Node* node,
-                         List<Unit, UnitAlloc>& units,
-                         std::vector<typename List<Unit, UnitAlloc>::iterator,
-                                     UnitIterAlloc>& buckets) {
-    size_t hash = hasher(node->value.key_val.first) % buckets.size();
-    node->value.hash = hash;
-    buckets[hash] = units.tieNeighboursToNewNode(bucketIsEmpty(buckets, hash) ?
-                                                                              units.end().getNode() :
-                                                                              buckets[hash].getNode(),
-                                                 node);
+    size_t new_bucket_count = bucketCountForSize(new_size);
+    if (new_bucket_count == bucket_count()) {
+        return;
+    }
+    relinkBuckets(new_bucket_count);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::rehash(size_t bucket_count) {
+    if (isMigrating()) {
+        finishMigration();
+    }
+    size_t min_bucket_count = size() / max_load_factor() + 1;
+    size_t new_bucket_count = policy.bucketCountFor(bucket_count > min_bucket_count ? bucket_count : min_bucket_count);
+    if (new_bucket_count != this->bucket_count()) {
+        relinkBuckets(new_bucket_count);
+    }
+    // relinkBuckets() keeps the old capacity around; an explicit rehash gives it back.
+    buckets.shrink_to_fit();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::shrink_to_fit() {
+    rehash(0);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::relinkBuckets(size_t new_bucket_count) {
+    // The relink below walks the list, not the old bucket heads, so the bucket array can be cleared
+    // and refilled in place whenever the new count fits in its capacity (always, when shrinking).
+    if (new_bucket_count <= buckets.capacity()) {
+        buckets.assign(new_bucket_count, nullptr);
+    } else {
+        buckets = takeBuckets(new_bucket_count);
+    }
+    policy.rehashTo(new_bucket_count);
+    // Relink the nodes in place: a node that opens a new bucket goes to the front of the list,
+    // any other node goes right after its bucket's head. Only next pointers are rewritten.
+    typename UnitList::BaseNode* before_head = &units.before_head;
+    typename UnitList::BaseNode* node = before_head->next;
+    before_head->next = nullptr;
+    size_t front_bucket = 0;
+    while (node != nullptr) {
+        typename UnitList::BaseNode* next = node->next;
+        size_t bucket = bucketOf(node);
+        if (bucketIsEmpty(buckets, bucket)) {
+            node->next = before_head->next;
+            before_head->next = node;
+            buckets[bucket] = before_head;
+            if (node->next != nullptr) {
+                buckets[front_bucket] = node;
+            }
+            front_bucket = bucket;
+        } else {
+            node->next = buckets[bucket]->next;
+            buckets[bucket]->next = node;
+        }
+        node = next;
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::insertNodeInList(typename UnitList::Node* node) {
+    bool old_table = inOldTable(node->value.hash);
+    auto& table = old_table ? old_buckets : buckets;
+    size_t bucket = tableIndex(old_table, node->value.hash);
+    if (!bucketIsEmpty(table, bucket)) {
+        units.tieAfter(table[bucket], node);
+        return Iterator(typename UnitList::iterator(node));
+    }
+    // A new bucket starts at the front of its table, which pushes the table's old front bucket's
+    // head to this node. The first node of an empty new table also becomes the old table's front.
+    typename UnitList::BaseNode* front = old_table ? oldTableFront() : &units.before_head;
+    bool opens_new_table = !old_table && isMigrating() && boundary == nullptr;
+    units.tieAfter(front, node);
+    if (node->next != nullptr) {
+        bool next_in_old_table = old_table || opens_new_table;
+        (next_in_old_table ? old_buckets : buckets)[tableIndex(next_in_old_table, hashOf(node->next))] = node;
+    }
+    if (opens_new_table) {
+        boundary = node;
+    }
+    table[bucket] = front;
+    return Iterator(typename UnitList::iterator(node));
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
 template<class... Args>
-std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator, bool>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::emplace(Args&&... args) {
+std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator, bool>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::emplace(Args&&... args) {
     rehash_if();
-    typename List<Unit, UnitAlloc>::Node* node = units.createNullNode();
-    AllocTraits::construct(alloc, &(node->value.key_val), std::forward<Args>(args)...);
-    size_t hash = node->value.hash = countHash(node->value.key_val.first);
-    if (bucketIsEmpty(buckets, hash)) {
-        buckets[hash] = units.tieNeighboursToNewNode(units.end().getNode(), node);
-        return std::pair<Iterator, bool>(Iterator(buckets[hash]), true);
-    }
+    typename UnitList::Node* node = createUnitNode(std::forward<Args>(args)...);
+    return insertUniqueNode(node, countHash(node->value.key_val.first));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<class... Args>
+std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator, bool>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::emplace_hashed(size_t hash,
+                                                                           Args&&... args) {
+    rehash_if();
+    typename UnitList::Node* node = createUnitNode(std::forward<Args>(args)...);
+    return insertUniqueNode(node, hash);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator, bool>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::insertUniqueNode(typename UnitList::Node* node,
+                                                                             size_t hash) {
+    node->value.hash = hash;
     auto value_was_found_in_bucket = findValueInBucket(hash, node->value.key_val.first);
     if (!value_was_found_in_bucket.second) {
         units.destroyNode(node);
         return value_was_found_in_bucket;
     }
-    buckets[hash] = units.tieNeighboursToNewNode(buckets[hash].getNode(), node);
-    return std::pair<Iterator, bool>(Iterator(buckets[hash]), true);
+    return std::pair<Iterator, bool>(insertNodeInList(node), true);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key, class... Args>
+std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator, bool>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::tryEmplace(__Key&& key,
+                                                                       Args&&... args) {
+    size_t hash = countHash(key);
+    return tryEmplaceHashed(hash, std::forward<__Key>(key), std::forward<Args>(args)...);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key, class... Args>
+std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator, bool>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::tryEmplaceHashed(size_t hash,
+                                                                             __Key&& key,
+                                                                             Args&&... args) {
+    // Probe before touching the allocator: a hit costs no node and no construction.
+    std::pair<Iterator, bool> value_was_found_in_bucket = findValueInBucket(hash, key);
+    if (!value_was_found_in_bucket.second) {
+        return value_was_found_in_bucket;
+    }
+    rehash_if();
+    return insertNewUnitAtBucketBegin(hash,
+                                      std::piecewise_construct,
+                                      std::forward_as_tuple(std::forward<__Key>(key)),
+                                      std::forward_as_tuple(std::forward<Args>(args)...));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<class... Args>
+std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator, bool>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::try_emplace(const Key& key,
+                                                                        Args&&... args) {
+    return tryEmplace(key, std::forward<Args>(args)...);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<class... Args>
+std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator, bool>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::try_emplace(Key&& key,
+                                                                        Args&&... args) {
+    return tryEmplace(std::move(key), std::forward<Args>(args)...);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<class __Value>
+std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator, bool>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::insert_or_assign(const Key& key,
+                                                                             __Value&& value) {
+    // value is only consumed by tryEmplace when it inserts, so it is still intact on a hit.
+    std::pair<Iterator, bool> result = tryEmplace(key, std::forward<__Value>(value));
+    if (!result.second) {
+        result.first->second = std::forward<__Value>(value);
+    }
+    return result;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<class __Value>
+std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::Iterator, bool>
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::insert_or_assign(Key&& key,
+                                                                             __Value&& value) {
+    std::pair<Iterator, bool> result = tryEmplace(std::move(key), std::forward<__Value>(value));
+    if (!result.second) {
+        result.first->second = std::forward<__Value>(value);
+    }
+    return result;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::erase(Iterator iter) {
+    eraseNode(iter);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::shrinkIf() {
+    // Shrinking relinks and reorders the whole list, so it only runs from insert, where a rehash
+    // may invalidate iterators anyway, never from erase, and waits for a pending incremental
+    // resize to end.
+    if (!isMigrating() && policy.needsShrink(size(), bucket_count())) {
+        rehash(0);
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::eraseNode(Iterator iter) {
+    typename UnitList::BaseNode* node = iter.listIterator().getBaseNode();
+    eraseRun(prevOf(node), node->next);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::UnitList::BaseNode*
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::prevOf(const typename UnitList::BaseNode* node) {
+    typename UnitList::BaseNode* prev = headOf(node);
+    while (prev->next != node) {
+        prev = prev->next;
+    }
+    return prev;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+bool UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::inSameBucket(const typename UnitList::BaseNode* left,
+                                                                         const typename UnitList::BaseNode* right) const {
+    bool left_old = inOldTable(hashOf(left));
+    bool right_old = inOldTable(hashOf(right));
+    return left_old == right_old && tableIndex(left_old, hashOf(left)) == tableIndex(right_old, hashOf(right));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::UnitList::BaseNode*&
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::headOf(const typename UnitList::BaseNode* node) {
+    bool old_table = inOldTable(hashOf(node));
+    return (old_table ? old_buckets : buckets)[tableIndex(old_table, hashOf(node))];
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::eraseRun(typename UnitList::BaseNode* prev,
+                                                                     typename UnitList::BaseNode* last) {
+    // Unlinks the nodes strictly between prev and last. Bucket runs are contiguous, so a bucket
+    // whose run starts inside the range loses its head, and only the bucket of last can have
+    // started inside the range and still have nodes left: it is re-anchored on prev. The same
+    // holds across the new/old table boundary, which just moves back to prev if it was erased.
+    const typename UnitList::BaseNode* before = prev != &units.before_head ? prev : nullptr;
+    bool erases_boundary = false;
+    for (typename UnitList::BaseNode* node = prev->next; node != last; before = node, node = node->next) {
+        if (before == nullptr || !inSameBucket(before, node)) {
+            headOf(node) = nullptr;
+        }
+        erases_boundary = erases_boundary || node == boundary;
+    }
+    if (erases_boundary) {
+        boundary = prev != &units.before_head ? prev : nullptr;
+    }
+    if (last != nullptr && (prev == &units.before_head || !inSameBucket(prev, last))) {
+        headOf(last) = prev;
+    }
+    units.erase_after(typename UnitList::const_iterator(prev), typename UnitList::const_iterator(last));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::erase(Iterator begin,
+                                                                       Iterator end) {
+    // The whole range goes in one run.
+    if (begin == end) {
+        return;
+    }
+    typename UnitList::BaseNode* first = begin.listIterator().getBaseNode();
+    eraseRun(prevOf(first), end.listIterator().getBaseNode());
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<class Predicate>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::eraseIf(Predicate pred) {
+    // One pass over the list; each maximal run of matching nodes is unlinked with one eraseRun.
+    size_t old_size = size();
+    typename UnitList::BaseNode* prev = &units.before_head;
+    while (prev->next != nullptr) {
+        typename UnitList::BaseNode* last = prev->next;
+        while (last != nullptr && pred(static_cast<typename UnitList::Node*>(last)->value.key_val)) {
+            last = last->next;
+        }
+        if (last != prev->next) {
+            eraseRun(prev, last);
+        }
+        if (last == nullptr) {
+            break;
+        }
+        prev = last;
+    }
+    return old_size - size();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy, class Predicate>
+size_t erase_if(UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>& unordered_map,
+                Predicate pred) {
+    return unordered_map.eraseIf(pred);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::erase(const Key& key) {
+    return eraseKey(key, countHash(key));
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-void UnorderedMap<Key, Value, Hash, Equal, Alloc>::erase(Iterator iter) {
-    Iterator next_iter = iter;
-    ++next_iter;
-    buckets[iter.hash()] = (next_iter.hash() == iter.hash() ? next_iter.listIterator() : Iterator().listIterator());
-    units.erase(iter.listIterator());
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key, typename>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::erase(__Key&& key) {
+    return eraseKey(key, countHash(key));
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-void UnorderedMap<Key, Value, Hash, Equal, Alloc>::erase(Iterator begin,
-                                                         Iterator end) {
-    while (begin != end) {
-        Iterator iter = begin;
-        ++begin;
-        erase(iter);
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::erase(const Key& key,
+                                                                    size_t hash) {
+    return eraseKey(key, hash);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key, typename>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::erase(const __Key& key,
+                                                                    size_t hash) {
+    return eraseKey(key, hash);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::eraseKey(const __Key& key,
+                                                                       size_t hash) {
+    Iterator iter = findKey(key, hash);
+    if (iter == end()) {
+        return 0;
     }
+    erase(iter);
+    return 1;
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-size_t UnorderedMap<Key, Value, Hash, Equal, Alloc>::bucket_count() const {
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::clear() {
+    // The bucket arrays keep their size and capacity, so refilling the map does not reallocate
+    // them; a resize that was still in progress is simply dropped along with the nodes.
+    units.clear();
+    buckets.assign(buckets.size(), nullptr);
+    old_buckets.clear();
+    old_buckets.shrink_to_fit();
+    migrated_buckets = 0;
+    boundary = nullptr;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::bucket_count() const {
     return buckets.size();
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-size_t UnorderedMap<Key, Value, Hash, Equal, Alloc>::size() const {
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::max_bucket_count() const {
+    return BucketAllocTraits::max_size(buckets.get_allocator());
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::bucket(const Key& key) const {
+    return bucketIndex(countHash(key));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key, typename>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::bucket(const __Key& key) const {
+    return bucketIndex(countHash(key));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::bucket_size(size_t bucket) const {
+    return std::distance(cbegin(bucket), cend(bucket));
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::LocalIterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::begin(size_t bucket) {
+    return LocalIterator(this, bucket, bucket + 1);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::ConstLocalIterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::begin(size_t bucket) const {
+    return cbegin(bucket);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::LocalIterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::end(size_t) {
+    return LocalIterator();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::ConstLocalIterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::end(size_t bucket) const {
+    return cend(bucket);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::ConstLocalIterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::cbegin(size_t bucket) const {
+    return ConstLocalIterator(this, bucket, bucket + 1);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::ConstLocalIterator
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::cend(size_t) const {
+    // Every local iterator ends on a null node, so end() needs no walk over the bucket.
+    return ConstLocalIterator();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::BucketRange
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::bucket_range(size_t first_bucket,
+                                                                          size_t last_bucket) {
+    // last_bucket is clamped so that callers can split [0, bucket_count()) by rounding up.
+    last_bucket = last_bucket < bucket_count() ? last_bucket : bucket_count();
+    return BucketRange(LocalIterator(this, first_bucket, last_bucket), LocalIterator());
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::ConstBucketRange
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::bucket_range(size_t first_bucket,
+                                                                          size_t last_bucket) const {
+    last_bucket = last_bucket < bucket_count() ? last_bucket : bucket_count();
+    return ConstBucketRange(ConstLocalIterator(this, first_bucket, last_bucket), ConstLocalIterator());
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::finish_rehash() {
+    if (isMigrating()) {
+        finishMigration();
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::size() const {
     return units.size();
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-size_t UnorderedMap<Key, Value, Hash, Equal, Alloc>::max_size() const {
-    return _max_size;
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::max_size() const {
+    return policy.max_size();
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-float UnorderedMap<Key, Value, Hash, Equal, Alloc>::load_factor() const {
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+float UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::load_factor() const {
     return static_cast<float>(size()) / bucket_count();
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-float UnorderedMap<Key, Value, Hash, Equal, Alloc>::max_load_factor() const {
-    return _max_load_factor;
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+float UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::max_load_factor() const {
+    return policy.max_load_factor();
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-void UnorderedMap<Key, Value, Hash, Equal, Alloc>::max_load_factor(float ml) {
-    _max_load_factor = ml;
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+float UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::min_load_factor() const {
+    return policy.min_load_factor();
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::min_load_factor(float ml) {
+    // Throws std::invalid_argument unless ml < max_load_factor() / growth_factor().
+    policy.min_load_factor(ml);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::max_load_factor(float ml) {
+    policy.max_load_factor(ml);
+    if (policy.needsRehash(size(), bucket_count())) {
+        reserve(size());
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+GrowthPolicy& UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::growth_policy() {
+    return policy;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+const GrowthPolicy& UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::growth_policy() const {
+    return policy;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::rehash_budget() const {
+    return _rehash_budget;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+bool UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::background_rehash() const {
+    return _background_rehash;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::background_rehash(bool enabled) {
+    // Only the clearing of the next bucket array moves to the helper; the relink stays on this
+    // thread, so the mode is useful only with an incremental resize. Enabling it sets
+    // rehash_budget() to kBackgroundRehashBudget unless a budget is already set.
+    _background_rehash = enabled;
+    if (enabled && _rehash_budget == 0) {
+        _rehash_budget = kBackgroundRehashBudget;
+    }
+    if (!enabled && prepared_buckets.valid()) {
+        prepared_buckets.get();
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::rehash_budget(size_t buckets_per_insert) {
+    // 0 restores the stop-the-world rehash, so an unfinished resize is completed right away and
+    // background_rehash() is turned off, since it needs an incremental resize.
+    _rehash_budget = buckets_per_insert;
+    if (_rehash_budget == 0) {
+        background_rehash(false);
+        if (isMigrating()) {
+            finishMigration();
+        }
+    }
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+bool UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::bucketIsEmpty(
+        const std::vector<typename UnitList::BaseNode*, BucketAlloc>& buckets,
+        size_t bucket) const {
+    return buckets[bucket] == nullptr;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+template<typename __Key>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::countHash(const __Key& key) const {
+    return hasher(key);
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::bucketIndex(size_t hash) const {
+    return policy.bucketIndex(hash);
+}
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::bucketOf(const typename UnitList::BaseNode* node) const {
+    return bucketIndex(hashOf(node));
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-bool UnorderedMap<Key, Value, Hash, Equal, Alloc>::bucketIsEmpty(
-        const std::vector<typename List<Unit, UnitAlloc>::iterator, UnitIterAlloc>& buckets,
-        size_t hash) const {
-    return buckets[hash] == typename List<Unit, UnitAlloc>::iterator();
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+const typename UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::UnitList::BaseNode*
+UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::firstNodeFrom(size_t& bucket,
+                                                                          size_t last_bucket) const {
+    // Advances bucket to the first non-empty bucket below last_bucket and returns its first node.
+    for (; bucket < last_bucket; ++bucket) {
+        if (!bucketIsEmpty(buckets, bucket)) {
+            return buckets[bucket]->next;
+        }
+    }
+    return nullptr;
+}
+
+template<class Key, class Value, class Hash, class Equal, class Alloc, class GrowthPolicy>
+size_t UnorderedMap<Key, Value, Hash, Equal, Alloc, GrowthPolicy>::hashOf(const typename UnitList::BaseNode* node) {
+    return static_cast<const typename UnitList::Node*>(node)->value.hash;
 }
 
-template<class Key, class Value, class Hash, class Equal, class Alloc>
-size_t UnorderedMap<Key, Value, Hash, Equal, Alloc>::countHash(const Key& key) const {
-    return hasher(key) % buckets.size();
-}
\ No newline at end of file
+namespace pmr {
+template<typename T>
+using List = ::List<T, std::pmr::polymorphic_allocator<T>>;
+
+template<typename T>
+using ForwardList = ::ForwardList<T, std::pmr::polymorphic_allocator<T>>;
+
+template<class Key, class Value, class Hash = std::hash<Key>, class Equal = std::equal_to<Key>,
+         class GrowthPolicy = PowerOfTwoGrowthPolicy>
+using UnorderedMap = ::UnorderedMap<Key, Value, Hash, Equal,
+                                    std::pmr::polymorphic_allocator<std::pair<const Key, Value>>, GrowthPolicy>;
+}